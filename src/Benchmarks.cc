@@ -0,0 +1,836 @@
+#include "Benchmarks.h"
+#include "Block.h"
+#include "Blockchain.h"
+#include "BlockTree.h"
+#include "ElGamal.h"
+#include "BigElGamal.h"
+#include "MontgomeryLanes.h"
+#include "PrimeGenerator.h"
+#include <omnetpp.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace omnetpp;
+using namespace std;
+
+namespace {
+
+typedef chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+    return chrono::duration<double>(Clock::now() - start).count();
+}
+
+double bytesPerSecond(int bytes, double seconds) {
+    return seconds > 0.0 ? bytes / seconds : 0.0;
+}
+
+string payloadLabel(size_t bytes) {
+    return bytes >= (1 << 20) ? to_string(bytes >> 20) + " MB" : to_string(bytes >> 10) + " KB";
+}
+
+// Milliseconds per call of op, repeated for at least minimumSeconds
+template <typename Operation>
+double millisecondsPerCall(Operation op, double minimumSeconds) {
+    int calls = 0;
+    Clock::time_point start = Clock::now();
+    do {
+        op();
+        calls++;
+    } while (secondsSince(start) < minimumSeconds);
+    return secondsSince(start) * 1000.0 / calls;
+}
+
+// Wire bytes of `block` re-addressed to `height` on top of `previousRef`. Only the
+// header changes, so a long chain can be built without per-block key generation.
+string readdressedBlock(const Block& block, size_t height, const string& previousRef) {
+    string wire = block.serialize();
+    BlockView view = BlockView::parse(wire);
+    BlockWireHeader header = BlockWireHeader::decode(wire.data(), wire.size());
+    header.blockNumber = (int32_t)height;
+    header.prevRefLength = (uint16_t)previousRef.size();
+
+    string out(header.wireSize(), '\0');
+    header.encode(&out[0]);
+    size_t pos = BlockWireHeader::SIZE;
+    out.replace(pos, previousRef.size(), previousRef);
+    pos += previousRef.size();
+    out.replace(pos, view.getSessionKeyHashSize(), view.getSessionKeyHash(), view.getSessionKeyHashSize());
+    pos += view.getSessionKeyHashSize();
+    out.replace(pos, view.getEncryptedDataSize(), view.getEncryptedData(), view.getEncryptedDataSize());
+    return out;
+}
+
+// Grows chain to `size` blocks of received copies of prototype, a batch at a
+// time; returns the seconds spent in addBlock alone. With `mine` set each copy
+// also gets a nonce meeting the prototype's target.
+double appendReaddressedBlocks(Blockchain& chain, const Block& prototype, size_t size, bool mine = false) {
+    const size_t batchSize = 4096;
+    double appendSeconds = 0.0;
+    vector<Block> batch(batchSize);
+    while (chain.getChainLength() < size) {
+        size_t count = min(batchSize, size - chain.getChainLength());
+        string previousRef = chain.getLatestBlockIdentifier();
+        for (size_t i = 0; i < count; i++) {
+            string wire = readdressedBlock(prototype, chain.getChainLength() + i, previousRef);
+            Block::deserialize(wire.data(), wire.size(), batch[i]);
+            while (mine && !batch[i].isMinedValid()) {
+                batch[i].setNonce(batch[i].getNonce() + 1);
+            }
+            previousRef = batch[i].getBlockIdentifier();
+        }
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < count; i++) {
+            chain.addBlock(move(batch[i]));
+        }
+        appendSeconds += secondsSince(start);
+    }
+    return appendSeconds;
+}
+
+// Resident set size from /proc (0 where it is unavailable)
+double residentMegabytes() {
+    ifstream statm("/proc/self/statm");
+    size_t totalPages = 0, residentPages = 0;
+    if (!(statm >> totalPages >> residentPages)) return 0.0;
+    return residentPages * (double)sysconf(_SC_PAGESIZE) / (1 << 20);
+}
+
+template <size_t Limbs>
+void benchmarkBigElGamal(mt19937_64& rng, int& failures) {
+    typedef BigElGamal<Limbs> Scheme;
+    typedef typename Scheme::Int Int;
+    const double minimumSeconds = 0.2;
+
+    typename Scheme::KeyPairType keyPair = Scheme::generateKeyPair(rng);
+    typename Scheme::PublicKeyType publicKey = Scheme::extractPublicKey(keyPair);
+    Int message = Int::randomInRange(Int::fromUint64(1), keyPair.p, rng);
+    message.limb[Limbs - 1] = 0;   // Comfortably below p
+    typename Scheme::CipherBlockType cipher = Scheme::encrypt(message, Scheme::randomExponent(keyPair.p, rng), publicKey);
+
+    double keygenMs = millisecondsPerCall([&] { keyPair = Scheme::generateKeyPair(rng); }, minimumSeconds);
+    publicKey = Scheme::extractPublicKey(keyPair);
+    double encryptMs = millisecondsPerCall([&] {
+        cipher = Scheme::encrypt(message, Scheme::randomExponent(keyPair.p, rng), publicKey);
+    }, minimumSeconds);
+    Int decrypted = Int::zero();
+    double decryptMs = millisecondsPerCall([&] { decrypted = Scheme::decrypt(cipher, keyPair); }, minimumSeconds);
+
+    // Packed messages round-trip, and a length field near 2^64 is rejected rather than wrapping
+    string text = "Big ElGamal packed message round trip";
+    bool verified = decrypted == message &&
+                    Scheme::decrypt_message(Scheme::encrypt_message(text, Scheme::randomExponent(keyPair.p, rng), publicKey),
+                                            keyPair) == text;
+    try {
+        Scheme::decrypt_message(string(8, '\xff'), keyPair);
+        verified = false;
+    } catch (const invalid_argument&) {
+    }
+    if (!verified) failures++;
+
+    EV << "║ " << setw(4) << Int::BITS << " ║ " << fixed << setprecision(3)
+       << setw(10) << keygenMs << " ║ " << setw(10) << encryptMs << " ║ "
+       << setw(10) << decryptMs << " ║ " << setw(8) << (verified ? "yes" : "NO") << " ║\n";
+}
+
+} // namespace
+
+void Benchmarks::runAll() {
+    runElGamalBenchmark(4096);
+    runBatchDecryptBenchmark(4096);
+    runHybridBenchmark();
+    runPrimeBenchmark();
+    runBigElGamalBenchmark();
+    runLaneBenchmark(4096);
+    runBlockCodecBenchmark();
+    runChainBenchmark();
+    runChainStoreBenchmark();
+    runValidationBenchmark();
+    runForkBenchmark();
+}
+
+void Benchmarks::runElGamalBenchmark(int messageBytes) {
+    string message(messageBytes, '\0');
+    for (int i = 0; i < messageBytes; i++) {
+        message[i] = (char)(32 + i % 95);
+    }
+
+    EV << "\n╔══════════════════════════════════════════════════════════════════════════════════╗\n"
+       << "║                  ELGAMAL THROUGHPUT BENCHMARK (" << setw(5) << messageBytes << " byte message)               ║\n"
+       << "╠═════════════╦═════════════════════════╦════════════╦═════════════════════════════╣\n"
+       << "║ Prime       ║ Encrypt B/s (div → mont)║ Stream B/s ║ Decrypt B/s (div → mont)    ║\n"
+       << "╠═════════════╬═════════════════════════╬════════════╬═════════════════════════════╣\n";
+
+    int mismatches = 0;
+    for (long long p : PrimeGenerator::getPrimes()) {
+        KeyPair keyPair = ElGamal::generateKeyPair(p, 2, PrimeGenerator::generateRandomInRange(2, p - 2));
+        PublicKey publicKey = ElGamal::extractPublicKey(keyPair);
+        long long r = PrimeGenerator::generateRandomInRange(100, p - 100);
+
+        // Baseline: the division-based per-byte arithmetic
+        vector<pair<long long, long long>> reference(messageBytes);
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < messageBytes; i++) {
+            long long m = (unsigned char)message[i];
+            long long c1 = ElGamal::mod_exp(publicKey.e1, r + i, p);
+            long long c2 = (long long)((__int128)m * ElGamal::mod_exp(publicKey.e2, r + i, p) % p);
+            reference[i] = {c1, c2};
+        }
+        double divEncrypt = secondsSince(start);
+
+        start = Clock::now();
+        string decryptedReference;
+        for (int i = 0; i < messageBytes; i++) {
+            long long c1d = ElGamal::mod_exp(reference[i].first, keyPair.d, p);
+            long long inv = ElGamal::mod_inverse(c1d, p);
+            decryptedReference.push_back((char)((__int128)reference[i].second * inv % p));
+        }
+        double divDecrypt = secondsSince(start);
+
+        // Montgomery path: same per-byte work through the cached key context
+        vector<pair<long long, long long>> cipher(messageBytes);
+        start = Clock::now();
+        for (int i = 0; i < messageBytes; i++) {
+            cipher[i] = ElGamal::encrypt_char((unsigned char)message[i], r + i, publicKey);
+        }
+        double montEncrypt = secondsSince(start);
+
+        // Incremental exponent walk used by encrypt_message
+        start = Clock::now();
+        EncryptionStream stream(publicKey, r);
+        vector<pair<long long, long long>> streamed(messageBytes);
+        for (int i = 0; i < messageBytes; i++) {
+            streamed[i] = stream.next((unsigned char)message[i]);
+        }
+        double streamEncrypt = secondsSince(start);
+
+        start = Clock::now();
+        string decrypted;
+        for (int i = 0; i < messageBytes; i++) {
+            decrypted.push_back((char)ElGamal::decrypt_char(cipher[i], keyPair));
+        }
+        double montDecrypt = secondsSince(start);
+
+        if (cipher != reference || streamed != reference || decrypted != message || decryptedReference != message ||
+            ElGamal::decrypt_message(ElGamal::encrypt_message(message, r, publicKey), keyPair) != message) {
+            mismatches++;
+        }
+
+        EV << "║ " << setw(11) << p << " ║ "
+           << fixed << setprecision(0) << setw(10) << bytesPerSecond(messageBytes, divEncrypt) << " → "
+           << setw(10) << bytesPerSecond(messageBytes, montEncrypt) << " ║ "
+           << setw(10) << bytesPerSecond(messageBytes, streamEncrypt) << " ║ "
+           << setw(10) << bytesPerSecond(messageBytes, divDecrypt) << " → "
+           << setw(10) << bytesPerSecond(messageBytes, montDecrypt) << "     ║\n";
+    }
+
+    EV << "╚═════════════╩═════════════════════════╩════════════╩═════════════════════════════╝\n"
+       << (mismatches == 0 ? "✅ All round trips matched\n" : "❌ Round-trip mismatches: ")
+       << (mismatches == 0 ? "" : to_string(mismatches) + "\n");
+}
+
+void Benchmarks::runBatchDecryptBenchmark(int messageBytes) {
+    string message(messageBytes, '\0');
+    for (int i = 0; i < messageBytes; i++) {
+        message[i] = (char)(32 + i % 95);
+    }
+
+    EV << "\n╔═════════════════════════════════════════════════════════╗\n"
+       << "║      BATCH DECRYPTION BENCHMARK (" << setw(5) << messageBytes << " byte message)    ║\n"
+       << "╠═════════════╦══════════════╦══════════════╦═════════════╣\n"
+       << "║ Prime       ║ Per-pair B/s ║ Batch B/s    ║ Speedup     ║\n"
+       << "╠═════════════╬══════════════╬══════════════╬═════════════╣\n";
+
+    int mismatches = 0;
+    for (long long p : PrimeGenerator::getPrimes()) {
+        KeyPair keyPair = ElGamal::generateKeyPair(p, 2, PrimeGenerator::generateRandomInRange(2, p - 2));
+        PublicKey publicKey = ElGamal::extractPublicKey(keyPair);
+        long long r = PrimeGenerator::generateRandomInRange(100, p - 100);
+
+        string ciphertext = ElGamal::encrypt_message(message, r, publicKey);
+        CiphertextView view = CiphertextView::parse(ciphertext);
+        vector<CipherBlock> pairs(view.size());
+        for (size_t i = 0; i < pairs.size(); i++) {
+            pairs[i] = view[i];
+        }
+
+        // Per pair: exponentiation plus an extended-Euclid inversion each
+        vector<long long> perPair(pairs.size());
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < pairs.size(); i++) {
+            perPair[i] = ElGamal::decrypt_char({pairs[i].c1, pairs[i].c2}, keyPair);
+        }
+        double perPairTime = secondsSince(start);
+
+        vector<long long> batched(pairs.size());
+        start = Clock::now();
+        ElGamal::decrypt_message(pairs.data(), pairs.size(), keyPair, batched.data());
+        double batchTime = secondsSince(start);
+
+        if (perPair != batched || ElGamal::decrypt_message(ciphertext, keyPair) != message) {
+            mismatches++;
+        }
+
+        EV << "║ " << setw(11) << p << " ║ "
+           << fixed << setprecision(0) << setw(12) << bytesPerSecond(messageBytes, perPairTime) << " ║ "
+           << setw(12) << bytesPerSecond(messageBytes, batchTime) << " ║ "
+           << setprecision(2) << setw(10) << (batchTime > 0.0 ? perPairTime / batchTime : 0.0) << "x ║\n";
+    }
+
+    // A length field of 2^60 one-byte elements in 8-byte limbs: its pair bytes
+    // wrap to 0 in size_t, so a wrapping size check would accept this 12-byte
+    // header as 2^60 pairs with nothing behind it
+    string crafted = {(char)FORMAT_BINARY, 8, 1};
+    crafted.append(8, (char)0x80);
+    crafted.push_back(0x10);
+    try {
+        CiphertextView::parse(crafted);
+        mismatches++;
+    } catch (const invalid_argument&) {
+    }
+
+    EV << "╚═════════════╩══════════════╩══════════════╩═════════════╝\n"
+       << (mismatches == 0 ? "✅ Batch and per-pair plaintexts matched\n" : "❌ Batch/per-pair mismatches: ")
+       << (mismatches == 0 ? "" : to_string(mismatches) + "\n");
+}
+
+void Benchmarks::runHybridBenchmark() {
+    // Largest prime: the most plaintext bytes per ElGamal element, i.e. its best case
+    long long p = PrimeGenerator::getPrimes().back();
+    KeyPair keyPair = ElGamal::generateKeyPair(p, 2, PrimeGenerator::generateRandomInRange(2, p - 2));
+    PublicKey publicKey = ElGamal::extractPublicKey(keyPair);
+
+    EV << "\n╔═════════════════════════════════════════════════════════════════════════╗\n"
+       << "║            HYBRID PAYLOAD THROUGHPUT (MB/s, p = " << setw(10) << p << ")             ║\n"
+       << "╠═════════════╦══════════════╦══════════════╦══════════════╦══════════════╣\n"
+       << "║ Payload     ║ Hybrid enc   ║ Hybrid dec   ║ ElGamal enc  ║ ElGamal dec  ║\n"
+       << "╠═════════════╬══════════════╬══════════════╬══════════════╬══════════════╣\n";
+
+    int mismatches = 0;
+    for (size_t size = 1 << 10; size <= (1 << 20); size <<= 2) {
+        string payload(size, '\0');
+        for (size_t i = 0; i < size; i++) {
+            payload[i] = (char)(32 + i % 95);
+        }
+
+        // Repeat small payloads so every measurement covers at least 1 MB
+        int repetitions = (int)max((size_t)1, (size_t)(1 << 20) / size);
+        double totalBytes = (double)size * repetitions;
+        double seconds[4];
+        CipherFormat formats[2] = {FORMAT_HYBRID, FORMAT_BINARY};
+
+        for (int f = 0; f < 2; f++) {
+            vector<string> ciphertexts(repetitions);
+            Clock::time_point start = Clock::now();
+            for (int rep = 0; rep < repetitions; rep++) {
+                long long r = PrimeGenerator::generateRandomInRange(100, p - 100);
+                ciphertexts[rep] = ElGamal::encrypt_message(payload, r, publicKey, formats[f]);
+            }
+            seconds[2 * f] = secondsSince(start);
+
+            start = Clock::now();
+            for (int rep = 0; rep < repetitions; rep++) {
+                if (ElGamal::decrypt_message(ciphertexts[rep], keyPair) != payload) {
+                    mismatches++;
+                }
+            }
+            seconds[2 * f + 1] = secondsSince(start);
+        }
+
+        EV << "║ " << setw(11) << payloadLabel(size) << " ║" << fixed << setprecision(2);
+        for (int i = 0; i < 4; i++) {
+            EV << " " << setw(12) << (seconds[i] > 0.0 ? totalBytes / seconds[i] / 1e6 : 0.0) << " ║";
+        }
+        EV << "\n";
+    }
+
+    EV << "╚═════════════╩══════════════╩══════════════╩══════════════╩══════════════╝\n"
+       << (mismatches == 0 ? "✅ All payloads decrypted correctly\n" : "❌ Payload mismatches: ")
+       << (mismatches == 0 ? "" : to_string(mismatches) + "\n");
+}
+
+void Benchmarks::runPrimeBenchmark() {
+    EV << "\n╔══════════════════════════════════════════════════╗\n"
+       << "║            PRIME GENERATION BENCHMARK            ║\n"
+       << "╠══════╦══════════════╦═══════════════╦════════════╣\n"
+       << "║ Bits ║ Primes/s     ║ Safe primes/s ║ Verified   ║\n"
+       << "╠══════╬══════════════╬═══════════════╬════════════╣\n";
+
+    // Each rate keeps generating for at least this long (and at least one prime)
+    const double minimumSeconds = 0.25;
+    int failures = 0;
+    const int sizes[] = {32, 64, 128};
+    for (int bits : sizes) {
+        double rates[2];
+        for (int safe = 0; safe < 2; safe++) {
+            int count = 0;
+            Clock::time_point start = Clock::now();
+            do {
+                uint128 p = safe ? PrimeGenerator::generateSafePrime(bits) : PrimeGenerator::generatePrime(bits);
+                bool exactBits = (p >> (bits - 1)) == 1;
+                if (!exactBits || !PrimeGenerator::isProbablePrime(p) ||
+                    (safe && !PrimeGenerator::isProbablePrime(p >> 1))) {
+                    failures++;
+                }
+                count++;
+            } while (secondsSince(start) < minimumSeconds);
+            rates[safe] = count / secondsSince(start);
+        }
+
+        EV << "║ " << setw(4) << bits << " ║ " << fixed << setprecision(1)
+           << setw(12) << rates[0] << " ║ " << setw(13) << rates[1] << " ║ "
+           << setw(10) << (failures == 0 ? "yes" : "NO") << " ║\n";
+    }
+
+    EV << "╚══════╩══════════════╩═══════════════╩════════════╝\n"
+       << (failures == 0 ? "✅ Every generated prime re-tested prime\n" : "❌ Prime verification failures: ")
+       << (failures == 0 ? "" : to_string(failures) + "\n");
+}
+
+void Benchmarks::runBigElGamalBenchmark() {
+    EV << "\n╔════════════════════════════════════════════════════════╗\n"
+       << "║   MULTI-LIMB ELGAMAL BENCHMARK (MODP groups, ms/op)    ║\n"
+       << "╠══════╦════════════╦════════════╦════════════╦══════════╣\n"
+       << "║ Bits ║ Keygen     ║ Encrypt    ║ Decrypt    ║ Verified ║\n"
+       << "╠══════╬════════════╬════════════╬════════════╬══════════╣\n";
+
+    mt19937_64 rng(chrono::steady_clock::now().time_since_epoch().count());
+    int failures = 0;
+    benchmarkBigElGamal<16>(rng, failures);
+    benchmarkBigElGamal<32>(rng, failures);
+    benchmarkBigElGamal<48>(rng, failures);
+
+    EV << "╚══════╩════════════╩════════════╩════════════╩══════════╝\n";
+
+    // The same 4 KiB message through ElGamal's key-size dispatch: native, then each MODP size
+    string message(4096, '\0');
+    for (size_t i = 0; i < message.size(); i++) {
+        message[i] = (char)(i * 131 + 7);
+    }
+    EV << "╔════════════════════════════════════════════════════════╗\n"
+       << "║   HYBRID 4 KiB MESSAGE BY KEY SIZE (ElGamal dispatch)  ║\n"
+       << "╠════════╦══════════════╦══════════════╦═════════════════╣\n"
+       << "║ Bits   ║ Encrypt ms   ║ Decrypt ms   ║ Verified        ║\n"
+       << "╠════════╬══════════════╬══════════════╬═════════════════╣\n";
+    SizedKeyPair previous;
+    for (int bits : {0, 1024, 2048, 3072}) {
+        SizedKeyPair keyPair = ElGamal::generateKeyPair(bits, rng);
+        SizedPublicKey publicKey = ElGamal::extractPublicKey(keyPair);
+        string ciphertext, decrypted;
+        double encryptMs = millisecondsPerCall([&] { ciphertext = ElGamal::encrypt_message(message, publicKey, rng); },
+                                               0.2);
+        double decryptMs = millisecondsPerCall([&] { decrypted = ElGamal::decrypt_message(ciphertext, keyPair); }, 0.2);
+
+        // A key of another size must refuse the ciphertext rather than misread it
+        bool verified = decrypted == message;
+        try {
+            ElGamal::decrypt_message(ciphertext, previous);
+            verified = false;
+        } catch (const invalid_argument&) {
+        }
+        if (!verified) failures++;
+        previous = keyPair;
+
+        EV << "║ " << setw(6) << (bits == 0 ? string("native") : to_string(bits)) << " ║ " << fixed
+           << setprecision(3) << setw(12) << encryptMs << " ║ " << setw(12) << decryptMs << " ║ "
+           << setw(15) << (verified ? "yes" : "NO") << " ║\n";
+    }
+    EV << "╚════════╩══════════════╩══════════════╩═════════════════╝\n"
+       << (failures == 0 ? "✅ All decryptions matched\n" : "❌ Decryption mismatches: ")
+       << (failures == 0 ? "" : to_string(failures) + "\n");
+}
+
+void Benchmarks::runLaneBenchmark(int messageBytes) {
+    string message(messageBytes, '\0');
+    for (int i = 0; i < messageBytes; i++) {
+        message[i] = (char)(32 + i % 95);
+    }
+
+    MontgomeryLanes::Backend best = MontgomeryLanes::detectBackend();
+    EV << "\n╔══════════════════════════════════════════════════════════════════╗\n"
+       << "║        MONTGOMERY LANE BENCHMARK (" << setw(9) << MontgomeryLanes::backendName(best)
+       << ", " << setw(5) << messageBytes << " byte message) ║\n"
+       << "╠═════════════╦══════════════╦══════════════╦═════════╦════════════╣\n"
+       << "║ Prime       ║ Scalar pow/s ║ Lane pow/s   ║ Speedup ║ Decrypt x  ║\n"
+       << "╠═════════════╬══════════════╬══════════════╬═════════╬════════════╣\n";
+
+    int mismatches = 0;
+    for (long long p : PrimeGenerator::getPrimes()) {
+        if (!MontgomeryLanes::supports((uint64_t)p)) continue;
+
+        KeyPair keyPair = ElGamal::generateKeyPair(p, 2, PrimeGenerator::generateRandomInRange(2, p - 2));
+        PublicKey publicKey = ElGamal::extractPublicKey(keyPair);
+        string ciphertext = ElGamal::encrypt_message(message, PrimeGenerator::generateRandomInRange(100, p - 100),
+                                                     publicKey);
+        CiphertextView view = CiphertextView::parse(ciphertext);
+        vector<uint64_t> bases(view.size());
+        for (size_t i = 0; i < bases.size(); i++) {
+            bases[i] = (uint64_t)view[i].c1;
+        }
+
+        // Same exponentiations and same decryption under each backend
+        double powSeconds[2], decryptSeconds[2];
+        vector<uint64_t> results[2];
+        string decrypted[2];
+        MontgomeryLanes::Backend backends[2] = {MontgomeryLanes::BACKEND_SCALAR, best};
+        for (int b = 0; b < 2; b++) {
+            MontgomeryLanes::setBackend(backends[b]);
+            results[b].resize(bases.size());
+            Clock::time_point start = Clock::now();
+            MontgomeryLanes::powMod(bases.data(), bases.size(), (uint64_t)keyPair.d, (uint64_t)p, results[b].data());
+            powSeconds[b] = secondsSince(start);
+
+            start = Clock::now();
+            decrypted[b] = ElGamal::decrypt_message(ciphertext, keyPair);
+            decryptSeconds[b] = secondsSince(start);
+        }
+        MontgomeryLanes::setBackend(best);
+
+        if (results[0] != results[1] || decrypted[0] != message || decrypted[1] != message) {
+            mismatches++;
+        }
+
+        EV << "║ " << setw(11) << p << " ║ " << fixed << setprecision(0)
+           << setw(12) << (powSeconds[0] > 0.0 ? bases.size() / powSeconds[0] : 0.0) << " ║ "
+           << setw(12) << (powSeconds[1] > 0.0 ? bases.size() / powSeconds[1] : 0.0) << " ║ "
+           << setprecision(2) << setw(6) << (powSeconds[1] > 0.0 ? powSeconds[0] / powSeconds[1] : 0.0) << "x ║ "
+           << setw(9) << (decryptSeconds[1] > 0.0 ? decryptSeconds[0] / decryptSeconds[1] : 0.0) << "x ║\n";
+    }
+
+    EV << "╚═════════════╩══════════════╩══════════════╩═════════╩════════════╝\n"
+       << (mismatches == 0 ? "✅ Lane and scalar results matched\n" : "❌ Lane/scalar mismatches: ")
+       << (mismatches == 0 ? "" : to_string(mismatches) + "\n");
+}
+
+void Benchmarks::runBlockCodecBenchmark() {
+    const double minimumSeconds = 0.2;
+
+    EV << "\n╔═══════════════════════════════════════════════════════════════════════════╗\n"
+       << "║                BLOCK CODEC ROUND TRIPS/s (text vs binary)                 ║\n"
+       << "╠═════════════╦════════════╦════════════╦════════════╦════════════╦═════════╣\n"
+       << "║ Payload     ║ Text       ║ Binary     ║ Reused     ║ View parse ║ Speedup ║\n"
+       << "╠═════════════╬════════════╬════════════╬════════════╬════════════╬═════════╣\n";
+
+    int mismatches = 0;
+    for (size_t size = 1 << 10; size <= (1 << 16); size <<= 3) {
+        string payload(size, '\0');
+        for (size_t i = 0; i < size; i++) {
+            payload[i] = (char)(32 + i % 95);
+        }
+        Block block(7, payload, "6_12345_00112233445566778899", FORMAT_HYBRID);
+        block.setNonce(12345);
+        block.setTimestamp(42.5);
+
+        double textMs = millisecondsPerCall([&] {
+            Block copy = Block::deserializeText(block.serializeText());
+            mismatches += copy.getEncryptedData().size() != block.getEncryptedData().size();
+        }, minimumSeconds);
+        double binaryMs = millisecondsPerCall([&] {
+            Block copy = Block::deserialize(block.serialize());
+            mismatches += copy.getEncryptedData().size() != block.getEncryptedData().size();
+        }, minimumSeconds);
+
+        // Steady state of a receive loop: one buffer and one Block reused throughout
+        string buffer;
+        Block reused;
+        double reusedMs = millisecondsPerCall([&] {
+            block.serializeTo(buffer);
+            Block::deserialize(buffer.data(), buffer.size(), reused);
+        }, minimumSeconds);
+
+        size_t viewed = 0;
+        double viewMs = millisecondsPerCall([&] {
+            viewed += BlockView::parse(buffer).getEncryptedDataSize();
+        }, minimumSeconds);
+
+        Block decoded = Block::deserialize(buffer);
+        if (viewed == 0 || decoded.serialize() != buffer || decoded.getEncryptedData() != block.getEncryptedData() ||
+            decoded.getPreviousBlockRef() != block.getPreviousBlockRef() || decoded.getNonce() != block.getNonce() ||
+            decoded.getTimestamp() != block.getTimestamp() || decoded.getPublicKey().p != block.getPublicKey().p) {
+            mismatches++;
+        }
+
+        EV << "║ " << setw(11) << payloadLabel(size) << " ║ " << fixed << setprecision(0)
+           << setw(10) << 1000.0 / textMs << " ║ "
+           << setw(10) << 1000.0 / binaryMs << " ║ "
+           << setw(10) << 1000.0 / reusedMs << " ║ "
+           << setw(10) << 1000.0 / viewMs << " ║ "
+           << setprecision(2) << setw(6) << textMs / binaryMs << "x ║\n";
+    }
+
+    EV << "╚═════════════╩════════════╩════════════╩════════════╩════════════╩═════════╝\n"
+       << (mismatches == 0 ? "✅ Binary blocks round-tripped\n" : "❌ Block codec mismatches: ")
+       << (mismatches == 0 ? "" : to_string(mismatches) + "\n");
+}
+
+void Benchmarks::runChainBenchmark() {
+    const size_t lookups = 1 << 20;
+
+    Block prototype(1, string(64, 'x'), "0", FORMAT_HYBRID);
+    prototype.setNonce(1);
+
+    EV << "\n╔═════════════════════════════════════════════════════════════════════════╗\n"
+       << "║              BLOCKCHAIN STORE (blocks or lookups per second)            ║\n"
+       << "╠═════════════╦══════════════╦══════════════╦══════════════╦══════════════╣\n"
+       << "║ Blocks      ║ Append       ║ By height    ║ By id        ║ Iterate      ║\n"
+       << "╠═════════════╬══════════════╬══════════════╬══════════════╬══════════════╣\n";
+
+    int mismatches = 0;
+    for (size_t size : {(size_t)100000, (size_t)1000000}) {
+        Blockchain chain;
+        chain.setRequireProofOfWork(false);   // The copies are linked but never mined
+
+        double appendSeconds = appendReaddressedBlocks(chain, prototype, size);
+
+        mt19937_64 rng(size);
+        vector<size_t> heights(lookups);
+        vector<string> identifiers(lookups / 16);
+        for (size_t& height : heights) {
+            height = rng() % size;
+        }
+        for (size_t i = 0; i < identifiers.size(); i++) {
+            identifiers[i] = chain.getBlockIdentifier(heights[i]);
+        }
+
+        // Block numbers equal heights, so both lookups can be checked against them
+        size_t expected = 0, found = 0;
+        for (size_t height : heights) expected += height;
+        Clock::time_point start = Clock::now();
+        for (size_t height : heights) {
+            found += chain.getBlockAt(height)->getBlockNumber();
+        }
+        double heightSeconds = secondsSince(start);
+        mismatches += found != expected;
+
+        size_t matched = 0;
+        start = Clock::now();
+        for (size_t i = 0; i < identifiers.size(); i++) {
+            const Block* block = chain.findBlock(identifiers[i]);
+            matched += block && (size_t)block->getBlockNumber() == heights[i];
+        }
+        double idSeconds = secondsSince(start);
+        mismatches += matched != identifiers.size();
+
+        start = Clock::now();
+        size_t visited = 0;
+        for (const Block& block : chain.getChain()) {
+            visited += !block.getEncryptedData().empty();
+        }
+        double iterateSeconds = secondsSince(start);
+        mismatches += visited != size || chain.getChainLength() != size || !chain.isChainValid();
+
+        EV << "║ " << setw(11) << size << " ║ " << fixed << setprecision(0)
+           << setw(12) << (appendSeconds > 0.0 ? size / appendSeconds : 0.0) << " ║ "
+           << setw(12) << (heightSeconds > 0.0 ? heights.size() / heightSeconds : 0.0) << " ║ "
+           << setw(12) << (idSeconds > 0.0 ? identifiers.size() / idSeconds : 0.0) << " ║ "
+           << setw(12) << (iterateSeconds > 0.0 ? size / iterateSeconds : 0.0) << " ║\n";
+    }
+
+    EV << "╚═════════════╩══════════════╩══════════════╩══════════════╩══════════════╝\n"
+       << (mismatches == 0 ? "✅ Chains linked and indexed\n" : "❌ Chain store mismatches: ")
+       << (mismatches == 0 ? "" : to_string(mismatches) + "\n");
+}
+
+void Benchmarks::runChainStoreBenchmark() {
+    Block prototype(1, string(64, 'x'), "0", FORMAT_HYBRID);
+    prototype.setNonce(1);
+
+    EV << "\n╔═════════════════════════════════════════════════════════════════════════════╗\n"
+       << "║                CHAIN STORE RESTART (mmap segments + index file)             ║\n"
+       << "╠═════════════╦════════════╦════════════╦════════════╦════════════╦══════════╣\n"
+       << "║ Blocks      ║ Write/s    ║ Open ms    ║ Open MB    ║ Parse ms   ║ Parse MB ║\n"
+       << "╠═════════════╬════════════╬════════════╬════════════╬════════════╬══════════╣\n";
+
+    int mismatches = 0;
+    for (size_t size : {(size_t)100000, (size_t)1000000}) {
+        char directoryTemplate[] = "/tmp/chainstore-XXXXXX";
+        if (!mkdtemp(directoryTemplate)) {
+            EV << "⚠️  Cannot create a temporary chain directory\n";
+            return;
+        }
+        string directory = directoryTemplate;
+
+        double writeSeconds;
+        string tipIdentifier;
+        {
+            Blockchain chain;
+            chain.openStorage(directory, Blockchain::SEGMENT_BLOCKS);   // One sync per segment
+            writeSeconds = appendReaddressedBlocks(chain, prototype, size);
+            tipIdentifier = chain.getLatestBlockIdentifier();
+        }
+#ifdef __GLIBC__
+        malloc_trim(0);   // Hand the written chain's heap back so the restart is measured from scratch
+#endif
+
+        // Cold start: index and identifiers only, blocks stay in the mappings
+        double baseMegabytes = residentMegabytes();
+        Clock::time_point start = Clock::now();
+        Blockchain restored;
+        restored.setRequireProofOfWork(false);
+        restored.openStorage(directory);
+        double openSeconds = secondsSince(start);
+        double openMegabytes = residentMegabytes() - baseMegabytes;
+
+        // Touching every block parses each segment once
+        start = Clock::now();
+        size_t visited = 0;
+        for (const Block& block : restored.getChain()) {
+            visited += !block.getEncryptedData().empty();
+        }
+        double parseSeconds = secondsSince(start);
+        double parsedMegabytes = residentMegabytes() - baseMegabytes;
+
+        if (restored.getChainLength() != size || visited != size || restored.getLatestBlockIdentifier() != tipIdentifier ||
+            restored.getStorageStats().droppedBlocks != 0 || !restored.isChainValid()) {
+            mismatches++;
+        }
+        restored.closeStorage();
+        ChainStore::remove(directory);
+
+        EV << "║ " << setw(11) << size << " ║ " << fixed << setprecision(0)
+           << setw(10) << (writeSeconds > 0.0 ? size / writeSeconds : 0.0) << " ║ "
+           << setw(10) << openSeconds * 1000.0 << " ║ "
+           << setw(10) << openMegabytes << " ║ "
+           << setw(10) << parseSeconds * 1000.0 << " ║ "
+           << setw(8) << parsedMegabytes << " ║\n";
+    }
+
+    EV << "╚═════════════╩════════════╩════════════╩════════════╩════════════╩══════════╝\n"
+       << (mismatches == 0 ? "✅ Stored chains restored intact\n" : "❌ Chain store mismatches: ")
+       << (mismatches == 0 ? "" : to_string(mismatches) + "\n");
+}
+
+void Benchmarks::runValidationBenchmark() {
+    const size_t size = 200000;
+    const size_t appended = Blockchain::SEGMENT_BLOCKS;
+
+    // One expected hash per mined copy keeps building the chain cheap
+    Block prototype(1, string(64, 'x'), "0", FORMAT_HYBRID);
+    prototype.setDifficultyTarget(Digest::targetFromBits(1).toCompact());
+    prototype.setNonce(1);
+
+    // Validation checks targets against the schedule: height 1 inherits the
+    // genesis target, every later height the 1-bit initial one
+    Blockchain chain;
+    chain.getDifficultyController().setInitialDifficulty(1);
+    Block first = prototype;
+    first.setDifficultyTarget(chain.getExpectedDifficulty(1));
+    appendReaddressedBlocks(chain, first, 2, true);
+    appendReaddressedBlocks(chain, prototype, size, true);
+
+    EV << "\n╔═════════════════════════════════════════════════════╗\n"
+       << "║   CHAIN REVALIDATION (proof of work + prev links)   ║\n"
+       << "╠═════════════╦══════════════╦══════════════╦═════════╣\n"
+       << "║ Threads     ║ Blocks/s     ║ ms           ║ Speedup ║\n"
+       << "╠═════════════╬══════════════╬══════════════╬═════════╣\n";
+
+    int mismatches = 0;
+    double baseSeconds = 0.0, fullSeconds = 0.0;
+    for (int threads : {1, 2, 4, 8, 16}) {
+        Clock::time_point start = Clock::now();
+        mismatches += !chain.revalidateChain(threads);
+        double seconds = secondsSince(start);
+        if (threads == 1) baseSeconds = seconds;
+        fullSeconds = seconds;
+
+        EV << "║ " << setw(11) << threads << " ║ " << fixed << setprecision(0)
+           << setw(12) << (seconds > 0.0 ? size / seconds : 0.0) << " ║ "
+           << setprecision(1) << setw(12) << seconds * 1000.0 << " ║ "
+           << setprecision(2) << setw(6) << (seconds > 0.0 ? baseSeconds / seconds : 0.0) << "x ║\n";
+    }
+    EV << "╚═════════════╩══════════════╩══════════════╩═════════╝\n";
+
+    // After a full pass only the appended suffix is checked
+    appendReaddressedBlocks(chain, prototype, size + appended, true);
+    Clock::time_point start = Clock::now();
+    mismatches += !chain.isChainValid() || chain.getValidatedHeight() != size + appended;
+    double incrementalSeconds = secondsSince(start);
+    EV << "Incremental check of " << appended << " appended blocks: " << fixed << setprecision(2)
+       << incrementalSeconds * 1000.0 << " ms (full pass on 16 threads: " << fullSeconds * 1000.0 << " ms)\n";
+
+    // A block that no longer meets its target is reported at its own height
+    size_t tampered = size / 2 + 123;
+    Block* block = chain.getBlockAt(tampered);
+    do {
+        block->setNonce(block->getNonce() + 1);
+    } while (block->isMinedValid());
+    mismatches += chain.revalidateChain(4) || chain.getValidatedHeight() != tampered;
+
+    EV << (mismatches == 0 ? "✅ Parallel and incremental validation agree\n" : "❌ Validation mismatches: ")
+       << (mismatches == 0 ? "" : to_string(mismatches) + "\n");
+}
+
+void Benchmarks::runForkBenchmark() {
+    const size_t size = 100000;
+
+    Block prototype(1, string(64, 'x'), "0", FORMAT_HYBRID);
+    Block rival(1, string(64, 'y'), "0", FORMAT_HYBRID);
+    prototype.setNonce(1);
+
+    Blockchain chain;
+    chain.setRequireProofOfWork(false);
+    appendReaddressedBlocks(chain, prototype, size);
+    BlockTree tree(chain, 128);
+
+    EV << "\n╔═════════════════════════════════════════════════════════╗\n"
+       << "║  FORK REORGANIZATION (10^5-block chain, ms per reorg)   ║\n"
+       << "╠═════════════╦═══════════════╦═══════════════╦═══════════╣\n"
+       << "║ Depth       ║ Block tree    ║ replaceChain  ║ Speedup   ║\n"
+       << "╠═════════════╬═══════════════╬═══════════════╬═══════════╣\n";
+
+    int mismatches = 0;
+    for (size_t depth : {(size_t)1, (size_t)4, (size_t)16, (size_t)64}) {
+        // A branch one block longer than the suffix it replaces, at the same target
+        size_t forkHeight = chain.getChainLength() - 1 - depth;
+        vector<Block> branch(depth + 1);
+        string previousRef = chain.getBlockIdentifier(forkHeight);
+        for (size_t i = 0; i < branch.size(); i++) {
+            string wire = readdressedBlock(rival, forkHeight + 1 + i, previousRef);
+            Block::deserialize(wire.data(), wire.size(), branch[i]);
+            branch[i].setNonce((int)depth + 1);   // Copies of one block differ only in number and nonce
+            previousRef = branch[i].getBlockIdentifier();
+        }
+
+        // Baseline: the whole competing chain handed to replaceChain
+        vector<Block> competing;
+        competing.reserve(forkHeight + 1 + branch.size());
+        for (const Block& block : chain.getChain(0, forkHeight + 1)) {
+            competing.push_back(block);
+        }
+        competing.insert(competing.end(), branch.begin(), branch.end());
+        Blockchain replaced;
+        replaced.replaceChain(vector<Block>(competing.begin(), competing.end() - 1));
+        Clock::time_point start = Clock::now();
+        mismatches += !replaced.replaceChain(competing);
+        double replaceSeconds = secondsSince(start);
+
+        // The tree switches only the differing suffix, on the last block's arrival
+        size_t reorgs = tree.getStats().reorgs;
+        start = Clock::now();
+        for (Block& block : branch) {
+            tree.addBlock(move(block));
+        }
+        double treeSeconds = secondsSince(start);
+        mismatches += tree.getStats().reorgs != reorgs + 1 || tree.getStats().lastReorgDepth != depth ||
+                      chain.getLatestBlockIdentifier() != previousRef || !chain.isChainValid();
+
+        EV << "║ " << setw(11) << depth << " ║ " << fixed << setprecision(3)
+           << setw(13) << treeSeconds * 1000.0 << " ║ "
+           << setw(13) << replaceSeconds * 1000.0 << " ║ "
+           << setprecision(0) << setw(8) << (treeSeconds > 0.0 ? replaceSeconds / treeSeconds : 0.0) << "x ║\n";
+    }
+
+    EV << "╚═════════════╩═══════════════╩═══════════════╩═══════════╝\n"
+       << (mismatches == 0 ? "✅ Reorganized onto every heavier branch\n" : "❌ Fork reorganization mismatches: ")
+       << (mismatches == 0 ? "" : to_string(mismatches) + "\n");
+}
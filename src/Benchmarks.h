@@ -0,0 +1,56 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+// Micro-benchmarks of the cryptographic hot paths, reported through EV.
+// Run once by node 0 when the runBenchmarks parameter is set.
+class Benchmarks {
+public:
+    static void runAll();
+
+    // ElGamal encrypt/decrypt throughput (bytes/s) for every prime in
+    // PrimeGenerator: 128-bit division baseline vs Montgomery reduction, plus
+    // the incremental exponent walk of EncryptionStream
+    static void runElGamalBenchmark(int messageBytes);
+
+    // Per-pair decrypt_char (one inversion each) vs batch decrypt_message
+    // (simultaneous inversion) over the same binary ciphertext
+    static void runBatchDecryptBenchmark(int messageBytes);
+
+    // FORMAT_HYBRID (ElGamal-KEM + ChaCha20) vs FORMAT_BINARY encrypt/decrypt
+    // throughput (MB/s) for block payloads from 1 KB to 1 MB
+    static void runHybridBenchmark();
+
+    // PrimeGenerator primes/s and safe primes/s at 32, 64 and 128 bits
+    static void runPrimeBenchmark();
+
+    // BigElGamal keygen, encrypt and decrypt latency at 1024, 2048 and 3072 bits, then
+    // a hybrid message through ElGamal's key-size dispatch at each size
+    static void runBigElGamalBenchmark();
+
+    // MontgomeryLanes scalar vs vector exponentiations/s for the sub-2^32 primes,
+    // and the batch decrypt_message speedup it gives
+    static void runLaneBenchmark(int messageBytes);
+
+    // Block round trips/s (serialize + deserialize) in the text and binary wire
+    // formats, deserializing into a reused Block, and BlockView parses/s
+    static void runBlockCodecBenchmark();
+
+    // Blockchain appends/s, lookups/s by height and by identifier, and blocks/s
+    // iterated through a ChainView, for chains of 10^5 to 10^6 blocks
+    static void runChainBenchmark();
+
+    // ChainStore write-through appends/s, then restart from disk: open time and
+    // resident memory with blocks left in the mappings vs after parsing them all
+    static void runChainStoreBenchmark();
+
+    // Full chain revalidation blocks/s on 1 to 16 threads (independent ranges,
+    // then a sequential stitch of the links between them), and the cost of an
+    // incremental check after one segment of appends
+    static void runValidationBenchmark();
+
+    // Reorganization onto a heavier branch 1 to 64 blocks deep: BlockTree
+    // switching the differing suffix vs replaceChain with the whole chain
+    static void runForkBenchmark();
+};
+
+#endif
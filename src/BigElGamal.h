@@ -0,0 +1,222 @@
+#ifndef BIGELGAMAL_H
+#define BIGELGAMAL_H
+
+#include <string>
+#include <vector>
+#include <random>
+#include <stdexcept>
+#include "BigInt.h"
+
+using namespace std;
+
+// Big-endian hex of the RFC 2409 / RFC 3526 MODP safe prime of the given size
+// (1024, 2048 or 3072 bits; generator 2). Throws invalid_argument for other sizes.
+const char* modpPrimeHex(size_t bits);
+
+template <size_t Limbs>
+struct BigKeyPair {
+    BigInt<Limbs> d;               // private key
+    BigInt<Limbs> e1, e2;          // public key components
+    BigInt<Limbs> p;               // prime modulus
+    BigMontgomery<Limbs> mont;     // Cached reduction context for p (never transmitted)
+};
+
+template <size_t Limbs>
+struct BigPublicKey {
+    BigInt<Limbs> e1, e2;          // public key components only
+    BigInt<Limbs> p;               // prime modulus
+    BigMontgomery<Limbs> mont;     // Cached reduction context for p
+};
+
+template <size_t Limbs>
+struct BigCipherBlock {
+    BigInt<Limbs> c1;
+    BigInt<Limbs> c2;
+};
+
+// ElGamal over BigInt<Limbs>: the same scheme as ElGamal at real key sizes
+// (Limbs = 16, 32, 48 for 1024, 2048, 3072 bits). Keys are drawn in the MODP
+// group of that size. All wire forms are constant-size, so no length fields.
+template <size_t Limbs>
+class BigElGamal {
+public:
+    typedef BigInt<Limbs> Int;
+    typedef BigKeyPair<Limbs> KeyPairType;
+    typedef BigPublicKey<Limbs> PublicKeyType;
+    typedef BigCipherBlock<Limbs> CipherBlockType;
+
+    static const size_t PUBLIC_KEY_BYTES = 3 * Int::BYTES;
+    static const size_t CIPHER_BLOCK_BYTES = 2 * Int::BYTES;
+    // Plaintext bytes per element: one byte short of the width keeps m < p
+    static const size_t BYTES_PER_ELEMENT = Int::BYTES - 1;
+
+    static KeyPairType generateKeyPair(mt19937_64& rng) {
+        Int p = Int::fromHex(modpPrimeHex(Int::BITS));
+        Int high = p;
+        high.subtractInPlace(Int::fromUint64(2));
+        return generateKeyPair(p, Int::fromUint64(2), Int::randomInRange(Int::fromUint64(2), high, rng));
+    }
+
+    static KeyPairType generateKeyPair(const Int& p, const Int& e1, const Int& d) {
+        KeyPairType key;
+        key.p = p;
+        key.e1 = e1;
+        key.d = d;
+        key.mont = BigMontgomery<Limbs>(p);
+        key.e2 = key.mont.powMod(e1, d);
+        return key;
+    }
+
+    static PublicKeyType extractPublicKey(const KeyPairType& keyPair) {
+        PublicKeyType publicKey;
+        publicKey.e1 = keyPair.e1;
+        publicKey.e2 = keyPair.e2;
+        publicKey.p = keyPair.p;
+        publicKey.mont = keyPair.mont;
+        return publicKey;
+    }
+
+    // Ephemeral exponent in [2, p - 2]
+    static Int randomExponent(const Int& p, mt19937_64& rng) {
+        Int high = p;
+        high.subtractInPlace(Int::fromUint64(2));
+        return Int::randomInRange(Int::fromUint64(2), high, rng);
+    }
+
+    // (e1^r, m * e2^r) for m < p
+    static CipherBlockType encrypt(const Int& m, const Int& r, const PublicKeyType& publicKey) {
+        const BigMontgomery<Limbs>& ctx = publicKey.mont;
+        CipherBlockType cipher;
+        cipher.c1 = ctx.powMod(publicKey.e1, r);
+        Int shared = ctx.pow(ctx.toMontgomery(publicKey.e2), r);
+        cipher.c2 = ctx.multiply(m, shared);   // m * (sR) * R^-1 = m * s
+        return cipher;
+    }
+
+    // m = c2 * c1^(p - 1 - d): Fermat's little theorem folds the inversion into the exponentiation
+    static Int decrypt(const CipherBlockType& cipher, const KeyPairType& keyPair) {
+        return decryptWith(cipher, keyPair, inverseExponent(keyPair));
+    }
+
+    // Packs BYTES_PER_ELEMENT bytes into each element under exponents r, r+1, ...,
+    // walking e1^k and e2^k by one multiply each as EncryptionStream does.
+    // Layout: 8-byte big-endian plaintext length, then CIPHER_BLOCK_BYTES per element.
+    static string encrypt_message(const string& message, const Int& r, const PublicKeyType& publicKey) {
+        const BigMontgomery<Limbs>& ctx = publicKey.mont;
+        Int e1Step = ctx.toMontgomery(publicKey.e1);
+        Int e2Step = ctx.toMontgomery(publicKey.e2);
+        Int c1Power = ctx.pow(e1Step, r);
+        Int sharedPower = ctx.pow(e2Step, r);
+
+        size_t elements = (message.size() + BYTES_PER_ELEMENT - 1) / BYTES_PER_ELEMENT;
+        string out(8 + elements * CIPHER_BLOCK_BYTES, '\0');
+        for (int i = 0; i < 8; i++) {
+            out[i] = (char)((uint64_t)message.size() >> (56 - 8 * i));
+        }
+
+        uint8_t element[Int::BYTES];
+        for (size_t k = 0; k < elements; k++) {
+            // Big-endian with a zero top byte, the final element zero-padded
+            memset(element, 0, sizeof(element));
+            size_t offset = k * BYTES_PER_ELEMENT;
+            size_t count = min(BYTES_PER_ELEMENT, message.size() - offset);
+            memcpy(element + 1, message.data() + offset, count);
+
+            CipherBlockType cipher;
+            cipher.c1 = ctx.fromMontgomery(c1Power);
+            cipher.c2 = ctx.multiply(Int::fromBytes(element), sharedPower);
+            serialize(cipher, (uint8_t*)&out[8 + k * CIPHER_BLOCK_BYTES]);
+
+            c1Power = ctx.multiply(c1Power, e1Step);
+            sharedPower = ctx.multiply(sharedPower, e2Step);
+        }
+        return out;
+    }
+
+    // Throws invalid_argument for a truncated or inconsistent buffer
+    static string decrypt_message(const string& ciphertext, const KeyPairType& keyPair) {
+        if (ciphertext.size() < 8) {
+            throw invalid_argument("Big ElGamal ciphertext is missing its length");
+        }
+        uint64_t length = 0;
+        for (int i = 0; i < 8; i++) {
+            length = (length << 8) | (uint8_t)ciphertext[i];
+        }
+        // Rounded up without length + BYTES_PER_ELEMENT - 1, which wraps for lengths near 2^64
+        size_t elements = (ciphertext.size() - 8) / CIPHER_BLOCK_BYTES;
+        uint64_t lengthElements = length / BYTES_PER_ELEMENT + (length % BYTES_PER_ELEMENT != 0);
+        if ((ciphertext.size() - 8) % CIPHER_BLOCK_BYTES != 0 || elements != lengthElements) {
+            throw invalid_argument("Big ElGamal ciphertext size does not match its length");
+        }
+
+        Int exponent = inverseExponent(keyPair);
+        string result;
+        result.reserve(elements * BYTES_PER_ELEMENT);
+        uint8_t element[Int::BYTES];
+        for (size_t k = 0; k < elements; k++) {
+            CipherBlockType cipher = deserialize((const uint8_t*)ciphertext.data() + 8 + k * CIPHER_BLOCK_BYTES);
+            decryptWith(cipher, keyPair, exponent).toBytes(element);
+            result.append((const char*)element + 1, BYTES_PER_ELEMENT);
+        }
+        result.resize(length);
+        return result;
+    }
+
+    // Constant-size wire forms
+    static void serialize(const CipherBlockType& cipher, uint8_t out[CIPHER_BLOCK_BYTES]) {
+        cipher.c1.toBytes(out);
+        cipher.c2.toBytes(out + Int::BYTES);
+    }
+
+    static CipherBlockType deserialize(const uint8_t in[CIPHER_BLOCK_BYTES]) {
+        CipherBlockType cipher;
+        cipher.c1 = Int::fromBytes(in);
+        cipher.c2 = Int::fromBytes(in + Int::BYTES);
+        return cipher;
+    }
+
+    static string publicKeyToBytes(const PublicKeyType& publicKey) {
+        string out(PUBLIC_KEY_BYTES, '\0');
+        uint8_t* bytes = (uint8_t*)&out[0];
+        publicKey.e1.toBytes(bytes);
+        publicKey.e2.toBytes(bytes + Int::BYTES);
+        publicKey.p.toBytes(bytes + 2 * Int::BYTES);
+        return out;
+    }
+
+    // Throws invalid_argument for a wrong size or unusable modulus
+    static PublicKeyType publicKeyFromBytes(const char* data, size_t size) {
+        if (size != PUBLIC_KEY_BYTES) {
+            throw invalid_argument("Malformed big ElGamal public key");
+        }
+        const uint8_t* bytes = (const uint8_t*)data;
+        PublicKeyType publicKey;
+        publicKey.e1 = Int::fromBytes(bytes);
+        publicKey.e2 = Int::fromBytes(bytes + Int::BYTES);
+        publicKey.p = Int::fromBytes(bytes + 2 * Int::BYTES);
+        publicKey.mont = BigMontgomery<Limbs>(publicKey.p);
+        if (!(publicKey.e1 < publicKey.p) || !(publicKey.e2 < publicKey.p)) {
+            throw invalid_argument("Big ElGamal public key components exceed the modulus");
+        }
+        return publicKey;
+    }
+
+private:
+    static Int inverseExponent(const KeyPairType& keyPair) {
+        Int exponent = keyPair.p;
+        exponent.subtractInPlace(Int::fromUint64(1));
+        exponent.subtractInPlace(keyPair.d);
+        return exponent;
+    }
+
+    static Int decryptWith(const CipherBlockType& cipher, const KeyPairType& keyPair, const Int& exponent) {
+        const BigMontgomery<Limbs>& ctx = keyPair.mont;
+        if (!(cipher.c1 < keyPair.p) || !(cipher.c2 < keyPair.p) || cipher.c1.isZero()) {
+            throw invalid_argument("Ciphertext values outside the key's group");
+        }
+        Int secretInverse = ctx.pow(ctx.toMontgomery(cipher.c1), exponent);
+        return ctx.multiply(cipher.c2, secretInverse);
+    }
+};
+
+#endif
@@ -0,0 +1,309 @@
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// Fixed-width unsigned integer of Limbs 64-bit limbs (least significant first).
+// Every value of a given width has the same size in memory and on the wire, so
+// nothing here allocates and the serialized form needs no length field.
+template <size_t Limbs>
+struct BigInt {
+    static const size_t LIMBS = Limbs;
+    static const size_t BITS = 64 * Limbs;
+    static const size_t BYTES = 8 * Limbs;
+
+    uint64_t limb[Limbs];
+
+    static BigInt zero() {
+        BigInt value;
+        memset(value.limb, 0, sizeof(value.limb));
+        return value;
+    }
+
+    static BigInt fromUint64(uint64_t x) {
+        BigInt value = zero();
+        value.limb[0] = x;
+        return value;
+    }
+
+    // Big-endian hex, at most BITS / 4 digits; throws invalid_argument
+    static BigInt fromHex(const string& hex) {
+        if (hex.empty() || hex.size() > BITS / 4) {
+            throw invalid_argument("Hex value does not fit the integer width");
+        }
+        BigInt value = zero();
+        size_t bit = 0;
+        for (size_t i = hex.size(); i-- > 0; bit += 4) {
+            char c = hex[i];
+            uint64_t digit;
+            if (c >= '0' && c <= '9') digit = c - '0';
+            else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+            else throw invalid_argument("Invalid hex digit");
+            value.limb[bit / 64] |= digit << (bit % 64);
+        }
+        return value;
+    }
+
+    string toHex() const {
+        static const char digits[] = "0123456789abcdef";
+        string hex;
+        for (size_t i = Limbs; i-- > 0;) {
+            for (int shift = 60; shift >= 0; shift -= 4) {
+                hex.push_back(digits[(limb[i] >> shift) & 0xf]);
+            }
+        }
+        size_t first = hex.find_first_not_of('0');
+        return first == string::npos ? "0" : hex.substr(first);
+    }
+
+    // Constant-size serialization: exactly BYTES big-endian bytes
+    void toBytes(uint8_t out[BYTES]) const {
+        for (size_t i = 0; i < Limbs; i++) {
+            uint64_t word = limb[Limbs - 1 - i];
+            for (int j = 0; j < 8; j++) {
+                out[8 * i + j] = (uint8_t)(word >> (56 - 8 * j));
+            }
+        }
+    }
+
+    static BigInt fromBytes(const uint8_t in[BYTES]) {
+        BigInt value;
+        for (size_t i = 0; i < Limbs; i++) {
+            uint64_t word = 0;
+            for (int j = 0; j < 8; j++) {
+                word = (word << 8) | in[8 * i + j];
+            }
+            value.limb[Limbs - 1 - i] = word;
+        }
+        return value;
+    }
+
+    bool isZero() const {
+        uint64_t any = 0;
+        for (size_t i = 0; i < Limbs; i++) any |= limb[i];
+        return any == 0;
+    }
+    bool isOdd() const { return limb[0] & 1; }
+    bool bit(size_t index) const { return (limb[index / 64] >> (index % 64)) & 1; }
+
+    size_t bitLength() const {
+        for (size_t i = Limbs; i-- > 0;) {
+            if (limb[i] != 0) return 64 * i + 64 - __builtin_clzll(limb[i]);
+        }
+        return 0;
+    }
+
+    int compare(const BigInt& other) const {
+        for (size_t i = Limbs; i-- > 0;) {
+            if (limb[i] != other.limb[i]) return limb[i] < other.limb[i] ? -1 : 1;
+        }
+        return 0;
+    }
+    bool operator==(const BigInt& other) const { return compare(other) == 0; }
+    bool operator!=(const BigInt& other) const { return compare(other) != 0; }
+    bool operator<(const BigInt& other) const { return compare(other) < 0; }
+
+    // this += other; returns the carry out of the top limb
+    uint64_t addInPlace(const BigInt& other) {
+        unsigned __int128 carry = 0;
+        for (size_t i = 0; i < Limbs; i++) {
+            carry += (unsigned __int128)limb[i] + other.limb[i];
+            limb[i] = (uint64_t)carry;
+            carry >>= 64;
+        }
+        return (uint64_t)carry;
+    }
+
+    // this -= other; returns the borrow out of the top limb
+    uint64_t subtractInPlace(const BigInt& other) {
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < Limbs; i++) {
+            uint64_t a = limb[i], b = other.limb[i];
+            uint64_t diff = a - b - borrow;
+            borrow = (a < b) || (a - b < borrow) ? 1 : 0;
+            limb[i] = diff;
+        }
+        return borrow;
+    }
+
+    // Uniform in [low, high] by rejection sampling; high must be >= low
+    static BigInt randomInRange(const BigInt& low, const BigInt& high, mt19937_64& rng) {
+        BigInt span = high;
+        span.subtractInPlace(low);
+        size_t bits = span.bitLength();
+        while (true) {
+            BigInt value = zero();
+            for (size_t i = 0; i < (bits + 63) / 64; i++) value.limb[i] = rng();
+            if (bits % 64 != 0) value.limb[bits / 64] &= (1ULL << (bits % 64)) - 1;
+            if (!(span < value)) {
+                value.addInPlace(low);
+                return value;
+            }
+        }
+    }
+};
+
+// Montgomery arithmetic modulo an odd n of up to Limbs limbs, R = 2^(64 * Limbs).
+// Products use the CIOS (coarsely integrated operand scanning) method: one pass
+// per limb of b that multiplies and reduces together, with one extra limb of
+// headroom and a single conditional subtraction at the end.
+template <size_t Limbs>
+class BigMontgomery {
+public:
+    typedef BigInt<Limbs> Int;
+
+private:
+    Int modulus;
+    uint64_t negInverse;   // -n^-1 mod 2^64
+    Int rSquared;          // R^2 mod n
+    Int rModN;             // R mod n, i.e. 1 in Montgomery form
+
+    // (a + b) mod n for a, b < n
+    Int addMod(const Int& a, const Int& b) const {
+        Int sum = a;
+        uint64_t carry = sum.addInPlace(b);
+        if (carry || !(sum < modulus)) sum.subtractInPlace(modulus);
+        return sum;
+    }
+
+    // Exponent window width by exponent length, as in common bignum libraries
+    static int windowBits(size_t exponentBits) {
+        if (exponentBits > 671) return 6;
+        if (exponentBits > 239) return 5;
+        if (exponentBits > 79) return 4;
+        if (exponentBits > 23) return 3;
+        return 1;
+    }
+
+public:
+    static const int MAX_WINDOW = 6;
+
+    // Unprepared context; isValid() is false
+    BigMontgomery() : modulus(Int::zero()), negInverse(0), rSquared(Int::zero()), rModN(Int::zero()) {}
+
+    // Throws invalid_argument unless n is odd and at least 3
+    explicit BigMontgomery(const Int& n) : modulus(n) {
+        if (!n.isOdd() || n.bitLength() < 2) {
+            throw invalid_argument("Montgomery modulus must be odd and at least 3");
+        }
+        uint64_t inverse = n.limb[0];   // Correct to 3 bits; each Newton step doubles that
+        for (int i = 0; i < 5; i++) {
+            inverse *= 2 - n.limb[0] * inverse;
+        }
+        negInverse = 0 - inverse;
+
+        // 2^k mod n by doubling: k = BITS gives R, k = 2 * BITS gives R^2
+        Int x = Int::fromUint64(1);
+        for (size_t i = 0; i < 2 * Int::BITS; i++) {
+            x = addMod(x, x);
+            if (i + 1 == Int::BITS) rModN = x;
+        }
+        rSquared = x;
+    }
+
+    bool isValid() const { return !modulus.isZero(); }
+    const Int& getModulus() const { return modulus; }
+    const Int& one() const { return rModN; }
+
+    // a * b * R^-1 mod n for a, b < n
+    Int multiply(const Int& a, const Int& b) const {
+        uint64_t t[Limbs + 2];
+        memset(t, 0, sizeof(t));
+
+        for (size_t i = 0; i < Limbs; i++) {
+            unsigned __int128 carry = 0;
+            for (size_t j = 0; j < Limbs; j++) {
+                carry += (unsigned __int128)a.limb[j] * b.limb[i] + t[j];
+                t[j] = (uint64_t)carry;
+                carry >>= 64;
+            }
+            carry += t[Limbs];
+            t[Limbs] = (uint64_t)carry;
+            t[Limbs + 1] = (uint64_t)(carry >> 64);
+
+            // Add m * n so the low limb cancels, then shift down one limb
+            uint64_t m = t[0] * negInverse;
+            carry = (unsigned __int128)m * modulus.limb[0] + t[0];
+            carry >>= 64;
+            for (size_t j = 1; j < Limbs; j++) {
+                carry += (unsigned __int128)m * modulus.limb[j] + t[j];
+                t[j - 1] = (uint64_t)carry;
+                carry >>= 64;
+            }
+            carry += t[Limbs];
+            t[Limbs - 1] = (uint64_t)carry;
+            t[Limbs] = t[Limbs + 1] + (uint64_t)(carry >> 64);
+        }
+
+        Int result;
+        memcpy(result.limb, t, sizeof(result.limb));
+        if (t[Limbs] != 0 || !(result < modulus)) {
+            result.subtractInPlace(modulus);
+        }
+        return result;
+    }
+
+    // x must already be below n
+    Int toMontgomery(const Int& x) const { return multiply(x, rSquared); }
+    Int fromMontgomery(const Int& x) const { return multiply(x, Int::fromUint64(1)); }
+
+    // Left-to-right sliding-window exponentiation: odd powers base^1, base^3, ...,
+    // base^(2^w - 1) are precomputed, so each window of up to w exponent bits
+    // costs one multiply on top of the squarings. Base and result in Montgomery form.
+    Int pow(const Int& montBase, const Int& exponent) const {
+        size_t bits = exponent.bitLength();
+        if (bits == 0) return rModN;
+
+        int window = windowBits(bits);
+        Int table[1 << (MAX_WINDOW - 1)];
+        table[0] = montBase;
+        if (window > 1) {
+            Int square = multiply(montBase, montBase);
+            for (int i = 1; i < (1 << (window - 1)); i++) {
+                table[i] = multiply(table[i - 1], square);
+            }
+        }
+
+        Int result = rModN;
+        long i = (long)bits - 1;
+        while (i >= 0) {
+            if (!exponent.bit(i)) {
+                result = multiply(result, result);
+                i--;
+                continue;
+            }
+            // Longest window i..low that ends in a set bit
+            long low = i - window + 1 > 0 ? i - window + 1 : 0;
+            while (!exponent.bit(low)) low++;
+
+            unsigned value = 0;
+            for (long k = i; k >= low; k--) {
+                result = multiply(result, result);
+                value = (value << 1) | (exponent.bit(k) ? 1 : 0);
+            }
+            result = multiply(result, table[value >> 1]);
+            i = low - 1;
+        }
+        return result;
+    }
+
+    // base^exp mod n on ordinary residues (base < n)
+    Int powMod(const Int& base, const Int& exponent) const {
+        return fromMontgomery(pow(toMontgomery(base), exponent));
+    }
+
+    // a*b mod n on ordinary residues (a, b < n)
+    Int mulMod(const Int& a, const Int& b) const {
+        return fromMontgomery(multiply(toMontgomery(a), toMontgomery(b)));
+    }
+};
+
+#endif
@@ -1,63 +1,211 @@
 #include "Block.h"
 #include "ElGamal.h"
-#include "PrimeGenerator.h"
+#include "KeyPool.h"
 #include "HashUtils.h"
 #include <sstream>
 #include <iomanip>
 #include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
 
 using namespace std;
 
-Block::Block(int blockNum, const string& blockData, const string& prevRef)
-    : blockNumber(blockNum), nonce(0), data(blockData), previousBlockRef(prevRef) {
+namespace {
+
+// Binary fields travel as "<length>:<bytes>" so they may contain any byte, '|' included
+void appendLengthPrefixed(stringstream& ss, const string& bytes) {
+    ss << bytes.size() << ":";
+    ss.write(bytes.data(), bytes.size());
+}
+
+string readField(const string& serialized, size_t& pos) {
+    size_t end = serialized.find('|', pos);
+    if (end == string::npos) end = serialized.size();
+    string field = serialized.substr(pos, end - pos);
+    pos = end + 1;
+    return field;
+}
+
+string readLengthPrefixed(const string& serialized, size_t& pos) {
+    size_t colon = serialized.find(':', pos);
+    if (colon == string::npos) {
+        throw invalid_argument("Missing length prefix in serialized block");
+    }
+    size_t length = stoull(serialized.substr(pos, colon - pos));
+    if (colon + 1 + length > serialized.size()) {
+        throw invalid_argument("Length-prefixed field overruns serialized block");
+    }
+    string field = serialized.substr(colon + 1, length);
+    pos = colon + 1 + length;
+    if (pos < serialized.size() && serialized[pos] != '|') {
+        throw invalid_argument("Missing separator after length-prefixed field");
+    }
+    pos++;
+    return field;
+}
+
+// Little-endian fixed-width fields of the binary wire format
+void storeLE(char* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out[i] = (char)(value >> (8 * i));
+    }
+}
+
+uint64_t loadLE(const char* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        value |= (uint64_t)(unsigned char)in[i] << (8 * i);
+    }
+    return value;
+}
+
+uint16_t checkedLength16(size_t length, const char* field) {
+    if (length > 0xffff) {
+        throw invalid_argument(string(field) + " too long for the block wire format");
+    }
+    return (uint16_t)length;
+}
+
+} // namespace
+
+void BlockWireHeader::encode(char out[SIZE]) const {
+    uint64_t timestampBits;
+    memcpy(&timestampBits, &timestamp, sizeof(timestampBits));
+
+    out[0] = (char)magic;
+    out[1] = (char)version;
+    storeLE(out + 2, prevRefLength, 2);
+    storeLE(out + 4, sessionHashLength, 2);
+    storeLE(out + 6, reserved, 2);
+    storeLE(out + 8, (uint32_t)blockNumber, 4);
+    storeLE(out + 12, (uint32_t)nonce, 4);
+    storeLE(out + 16, difficultyTarget, 4);
+    storeLE(out + 20, bodyLength, 4);
+    storeLE(out + 24, timestampBits, 8);
+    storeLE(out + 32, (uint64_t)e1, 8);
+    storeLE(out + 40, (uint64_t)e2, 8);
+    storeLE(out + 48, (uint64_t)p, 8);
+}
+
+BlockWireHeader BlockWireHeader::decode(const char* data, size_t size) {
+    if (size < SIZE) {
+        throw invalid_argument("Serialized block is shorter than its header");
+    }
+    BlockWireHeader header;
+    header.magic = (uint8_t)data[0];
+    header.version = (uint8_t)data[1];
+    if (header.magic != MAGIC) {
+        throw invalid_argument("Serialized block is not in the binary wire format");
+    }
+    if (header.version != VERSION) {
+        throw invalid_argument("Unsupported block wire format version " + to_string(header.version));
+    }
+    header.prevRefLength = (uint16_t)loadLE(data + 2, 2);
+    header.sessionHashLength = (uint16_t)loadLE(data + 4, 2);
+    header.reserved = (uint16_t)loadLE(data + 6, 2);
+    header.blockNumber = (int32_t)(uint32_t)loadLE(data + 8, 4);
+    header.nonce = (int32_t)(uint32_t)loadLE(data + 12, 4);
+    header.difficultyTarget = (uint32_t)loadLE(data + 16, 4);
+    header.bodyLength = (uint32_t)loadLE(data + 20, 4);
+    uint64_t timestampBits = loadLE(data + 24, 8);
+    memcpy(&header.timestamp, &timestampBits, sizeof(timestampBits));
+    header.e1 = (int64_t)loadLE(data + 32, 8);
+    header.e2 = (int64_t)loadLE(data + 40, 8);
+    header.p = (int64_t)loadLE(data + 48, 8);
+    return header;
+}
+
+// Takes a pre-generated ElGamal key pair and session key for this block
+Block::Block(int blockNum, const string& blockData, const string& prevRef, CipherFormat payloadFormat)
+    : Block(blockNum, blockData, prevRef, KeyPool::instance().acquire(), payloadFormat) {}
+
+Block::Block(int blockNum, const string& blockData, const string& prevRef, const KeyMaterial& material,
+             CipherFormat payloadFormat)
+    : blockNumber(blockNum), nonce(0),
+      difficultyTarget(Digest::targetFromBits(HashUtils::DEFAULT_DIFFICULTY_BITS).toCompact()),
+      timestamp(0.0), data(blockData), previousBlockRef(prevRef), decryptedValid(false) {
+
+    keyPair = material.keyPair;
 
-    // Generate ElGamal key pair for this block
-    keyPair = ElGamal::generateKeyPair();
-    
     // Extract public key (safe for transmission)
     publicKey = ElGamal::extractPublicKey(keyPair);
 
-    // Generate random session key for encryption
-    sessionKey = PrimeGenerator::generateRandomInRange(100, keyPair.p - 100);
+    sessionKey = material.sessionKey;
     
     // Generate public hash of session key (for verification without exposing key)
     publicSessionKeyHash = generateSessionKeyHash(sessionKey);
 
     // Encrypt the block data using PUBLIC KEY ONLY
-    encryptedData = ElGamal::encrypt_message(blockData, sessionKey, publicKey);
+    encryptedData = ElGamal::encrypt_message(blockData, sessionKey, publicKey, payloadFormat);
 }
 
 string Block::getData() const {
-    // Decrypt data when requested using PRIVATE KEY
-    return ElGamal::decrypt_message(encryptedData, keyPair);
+    // Decrypt data when first requested using PRIVATE KEY
+    if (!decryptedValid) {
+        decryptedData = ElGamal::decrypt_message(encryptedData, keyPair);
+        decryptedValid = true;
+    }
+    return decryptedData;
 }
 
-// Calculate hash for mining purposes
-string Block::calculateMiningHash() const {
+// Everything hashed for proof-of-work up to the nonce; constant while mining
+string Block::getMiningHeaderPrefix() const {
     stringstream ss;
     ss << blockNumber << "|"
-       << encryptedData << "|"
-       << previousBlockRef << "|"
-       << ElGamal::publicKeyToString(publicKey) << "|"
-       << nonce;  // Nonce affects the hash!
-    
-    return HashUtils::calculateSHA256(ss.str());
+       << difficultyTarget << "|"
+       << fixed << setprecision(6) << timestamp << "|";
+    appendLengthPrefixed(ss, encryptedData);
+    ss << "|" << previousBlockRef << "|";
+    appendLengthPrefixed(ss, ElGamal::publicKeyToBytes(publicKey));
+    ss << "|";
+    return ss.str();
+}
+
+// Header serialization hashed for proof-of-work
+string Block::getMiningHashInput(int miningNonce) const {
+    return getMiningHeaderPrefix() + to_string(miningNonce);  // Nonce affects the hash!
+}
+
+// Calculate hash for mining purposes
+Digest Block::calculateMiningHash() const {
+    return HashUtils::calculateSHA256(getMiningHashInput(nonce));
+}
+
+// Validate the proof-of-work against the target recorded in the header
+bool Block::isMinedValid() const {
+    return calculateMiningHash().meetsTarget(getTarget());
 }
 
 // Validate if block was properly mined
-bool Block::isMinedValid(int difficulty) const {
-    string blockHash = calculateMiningHash();
-    return HashUtils::isHashValid(blockHash, difficulty);
+bool Block::isMinedValid(int difficultyBits) const {
+    return HashUtils::isHashValid(calculateMiningHash(), difficultyBits);
+}
+
+// Validate several blocks at once through the multi-buffer SHA-256 kernels
+vector<bool> Block::isMinedValidBatch(const vector<const Block*>& blocks) {
+    vector<string> inputs;
+    inputs.reserve(blocks.size());
+    for (const Block* block : blocks) {
+        inputs.push_back(block->getMiningHashInput(block->nonce));
+    }
+
+    vector<Digest> hashes = HashUtils::calculateSHA256Batch(inputs);
+    vector<bool> valid(blocks.size());
+    for (size_t i = 0; i < blocks.size(); i++) {
+        valid[i] = hashes[i].meetsTarget(blocks[i]->getTarget());
+    }
+    return valid;
 }
 
 bool Block::isValidBlock() const {
     try {
         // Validate structure and encryption
-        std::string decrypted = ElGamal::decrypt_message(encryptedData, keyPair);
+        std::string decrypted = getData();
         bool structurallyValid = !decrypted.empty() && !encryptedData.empty();
         
         // Also validate mining (if nonce > 0, assume it was mined)
-        bool miningValid = (nonce == 0) || isMinedValid(4); // Default difficulty 4
+        bool miningValid = (nonce == 0) || isMinedValid();
         
         return structurallyValid && miningValid;
     } catch (...) {
@@ -66,48 +214,145 @@ bool Block::isValidBlock() const {
 }
 
 string Block::getBlockIdentifier() const {
-    // Include nonce in identifier for mined blocks
-    stringstream ss;
-    ss << blockNumber << "_" << nonce << "_" << encryptedData.substr(0, 20);
-    return ss.str();
+    return makeIdentifier(blockNumber, nonce, encryptedData.data(), encryptedData.size());
 }
 
-// SECURE serialization - NO PRIVATE KEYS!
+string Block::makeIdentifier(int blockNumber, int nonce, const char* encrypted, size_t encryptedSize) {
+    // Include nonce in identifier for mined blocks; the ciphertext tail is random
+    // and binary, so it is hex-encoded (the head is only the format header)
+    size_t tail = min((size_t)10, encryptedSize);
+    return to_string(blockNumber) + "_" + to_string(nonce) + "_" +
+           HashUtils::toHex((const unsigned char*)encrypted + encryptedSize - tail, tail);
+}
+
+// Binary wire format: BlockWireHeader, then the variable-length fields
 string Block::serialize() const {
+    string out;
+    serializeTo(out);
+    return out;
+}
+
+void Block::serializeTo(string& out) const {
+    BlockWireHeader header;
+    header.magic = BlockWireHeader::MAGIC;
+    header.version = BlockWireHeader::VERSION;
+    header.prevRefLength = checkedLength16(previousBlockRef.size(), "Previous block reference");
+    header.sessionHashLength = checkedLength16(publicSessionKeyHash.size(), "Session key hash");
+    header.reserved = 0;
+    header.blockNumber = blockNumber;
+    header.nonce = nonce;
+    header.difficultyTarget = difficultyTarget;
+    if (encryptedData.size() > 0xffffffffULL) {
+        throw invalid_argument("Encrypted payload too long for the block wire format");
+    }
+    header.bodyLength = (uint32_t)encryptedData.size();
+    header.timestamp = timestamp;
+    header.e1 = publicKey.e1;   // PUBLIC KEY ONLY!
+    header.e2 = publicKey.e2;
+    header.p = publicKey.p;
+
+    out.resize(header.wireSize());
+    char* cursor = &out[0];
+    header.encode(cursor);
+    cursor += BlockWireHeader::SIZE;
+    memcpy(cursor, previousBlockRef.data(), previousBlockRef.size());
+    cursor += previousBlockRef.size();
+    memcpy(cursor, publicSessionKeyHash.data(), publicSessionKeyHash.size());
+    cursor += publicSessionKeyHash.size();
+    memcpy(cursor, encryptedData.data(), encryptedData.size());
+}
+
+Block Block::deserialize(const string& serialized) {
+    if (!BlockView::isBinary(serialized)) {
+        return deserializeText(serialized);
+    }
+    Block block;
+    BlockView::parse(serialized).copyTo(block);
+    return block;
+}
+
+void Block::deserialize(const char* data, size_t size, Block& into) {
+    BlockView::parse(data, size).copyTo(into);
+}
+
+BlockView BlockView::parse(const char* data, size_t size) {
+    BlockView view;
+    view.header = BlockWireHeader::decode(data, size);
+    if (view.header.wireSize() != size) {
+        throw invalid_argument("Serialized block size does not match its header");
+    }
+    view.prevRef = data + BlockWireHeader::SIZE;
+    view.sessionHash = view.prevRef + view.header.prevRefLength;
+    view.body = view.sessionHash + view.header.sessionHashLength;
+    return view;
+}
+
+PublicKey BlockView::getPublicKey() const {
+    PublicKey publicKey;
+    publicKey.e1 = header.e1;
+    publicKey.e2 = header.e2;
+    publicKey.p = header.p;
+
+    // As for the other key decoders, a bad modulus is only reported on use
+    try {
+        publicKey.mont = MontgomeryContext((uint64_t)publicKey.p);
+    } catch (const invalid_argument&) {
+        publicKey.mont = MontgomeryContext();
+    }
+    return publicKey;
+}
+
+void BlockView::copyTo(Block& block) const {
+    // NOTE: remote blocks never carry the private key or session key
+    block.blockNumber = header.blockNumber;
+    block.nonce = header.nonce;
+    block.difficultyTarget = header.difficultyTarget;
+    block.timestamp = header.timestamp;
+    block.data.clear();
+    block.encryptedData.assign(body, header.bodyLength);
+    block.previousBlockRef.assign(prevRef, header.prevRefLength);
+    block.keyPair = KeyPair();
+    block.publicKey = getPublicKey();
+    block.sessionKey = 0;
+    block.publicSessionKeyHash.assign(sessionHash, header.sessionHashLength);
+    block.decryptedData.clear();
+    block.decryptedValid = false;
+}
+
+// SECURE serialization - NO PRIVATE KEYS!
+string Block::serializeText() const {
     stringstream ss;
     ss << blockNumber << "|"
-       << nonce << "|"
+       << nonce << "|";
        // REMOVED: << data << "|"                    // NO PLAINTEXT DATA!
-       << encryptedData << "|"                        // Encrypted data only
-       << previousBlockRef << "|"
-       << ElGamal::publicKeyToString(publicKey) << "|"  // PUBLIC KEY ONLY!
-       << publicSessionKeyHash;                       // SESSION KEY HASH ONLY!
+    appendLengthPrefixed(ss, encryptedData);          // Encrypted data only (binary)
+    ss << "|"
+       << previousBlockRef << "|";
+    appendLengthPrefixed(ss, ElGamal::publicKeyToBytes(publicKey));  // PUBLIC KEY ONLY!
+    ss << "|"
+       << publicSessionKeyHash << "|"                 // SESSION KEY HASH ONLY!
        // REMOVED: << sessionKey;                    // NO SESSION KEY!
+       << difficultyTarget << "|"
+       << fixed << setprecision(6) << timestamp;
     return ss.str();
 }
 
-Block Block::deserialize(const std::string& serialized) {
-    stringstream ss(serialized);
-    string item;
+Block Block::deserializeText(const std::string& serialized) {
+    size_t pos = 0;
 
-    getline(ss, item, '|');
-    int blockNum = stoi(item);
-
-    getline(ss, item, '|');
-    int blockNonce = stoi(item);
+    int blockNum = stoi(readField(serialized, pos));
+    int blockNonce = stoi(readField(serialized, pos));
 
     // REMOVED: plaintext data reading
-    getline(ss, item, '|');
-    string encrypted = item;
-
-    getline(ss, item, '|');
-    string prevRef = item;
+    string encrypted = readLengthPrefixed(serialized, pos);
+    string prevRef = readField(serialized, pos);
 
-    getline(ss, item, '|');
-    PublicKey pubKey = ElGamal::stringToPublicKey(item);  // PUBLIC KEY ONLY
+    string keyBytes = readLengthPrefixed(serialized, pos);
+    PublicKey pubKey = ElGamal::publicKeyFromBytes(keyBytes.data(), keyBytes.size());  // PUBLIC KEY ONLY
 
-    getline(ss, item, '|');
-    string sessionKeyHash = item;
+    string sessionKeyHash = readField(serialized, pos);
+    uint32_t compactTarget = (uint32_t)stoul(readField(serialized, pos));
+    double blockTimestamp = stod(readField(serialized, pos));
 
     // NOTE: We cannot fully reconstruct the block without private key and session key
     // This is intentional - remote nodes can only see public data
@@ -118,6 +363,8 @@ Block Block::deserialize(const std::string& serialized) {
     block.previousBlockRef = prevRef;
     block.publicKey = pubKey;
     block.publicSessionKeyHash = sessionKeyHash;
+    block.difficultyTarget = compactTarget;
+    block.timestamp = blockTimestamp;
 
     return block;
 }
@@ -3,14 +3,48 @@
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <vector>
 #include "ElGamal.h"
+#include "Digest.h"
+#include "HashUtils.h"
 
 using namespace std;
 
+struct KeyMaterial;
+
+// Fixed part of the binary block wire format. On the wire it is SIZE bytes,
+// little-endian, followed by prevRefLength bytes of previous reference,
+// sessionHashLength bytes of session key hash and bodyLength bytes of
+// encrypted payload, in that order.
+struct BlockWireHeader {
+    static const uint8_t MAGIC = 0xB1;     // Never a digit, so text blocks are told apart
+    static const uint8_t VERSION = 1;
+    static const size_t SIZE = 56;
+
+    uint8_t magic;
+    uint8_t version;
+    uint16_t prevRefLength;
+    uint16_t sessionHashLength;
+    uint16_t reserved;             // Zero in version 1
+    int32_t blockNumber;
+    int32_t nonce;
+    uint32_t difficultyTarget;
+    uint32_t bodyLength;
+    double timestamp;
+    int64_t e1, e2, p;             // Public key
+
+    void encode(char out[SIZE]) const;
+    // Throws invalid_argument for a short buffer, wrong magic or unknown version
+    static BlockWireHeader decode(const char* data, size_t size);
+    size_t wireSize() const { return SIZE + prevRefLength + sessionHashLength + bodyLength; }
+};
+
 class Block {
 private:
     int blockNumber;
     int nonce;
+    uint32_t difficultyTarget;    // Compact PoW target this block was mined against
+    double timestamp;             // Simulation time (s) the block was sealed
     string data;                    // Original data (never transmitted)
     string encryptedData;          // Encrypted data for transmission
     string previousBlockRef;
@@ -18,51 +52,121 @@ private:
     PublicKey publicKey;          // PUBLIC - safe for transmission
     long long sessionKey;         // PRIVATE - never transmitted
     string publicSessionKeyHash;  // PUBLIC - hash of session key for verification
+    mutable string decryptedData; // Memoized getData() result
+    mutable bool decryptedValid;
 
 public:
     // Default constructor for container compatibility
-    Block() : blockNumber(0), nonce(0), sessionKey(0) {}
+    Block() : blockNumber(0), nonce(0),
+              difficultyTarget(Digest::targetFromBits(HashUtils::DEFAULT_DIFFICULTY_BITS).toCompact()),
+              timestamp(0.0), sessionKey(0), decryptedValid(false) {}
     
-    // Main constructor
-    Block(int blockNum, const string& blockData, const string& prevRef);
+    // Main constructor; the payload is encrypted under a fresh per-block key pair
+    // with sessionKey as the ephemeral exponent (FORMAT_HYBRID: the KEM exponent)
+    Block(int blockNum, const string& blockData, const string& prevRef,
+          CipherFormat payloadFormat = FORMAT_BINARY);
+    // Same with caller-supplied key material, for blocks every node must derive
+    // byte for byte (the genesis block)
+    Block(int blockNum, const string& blockData, const string& prevRef, const KeyMaterial& material,
+          CipherFormat payloadFormat = FORMAT_BINARY);
 
-    // Copy constructor and assignment operator
+    // Copy and move constructors and assignment operators
     Block(const Block& other) = default;
     Block& operator=(const Block& other) = default;
+    Block(Block&& other) = default;
+    Block& operator=(Block&& other) = default;
 
     // Getters
     int getBlockNumber() const { return blockNumber; }
     int getNonce() const { return nonce; }
-    string getData() const;  // Decrypts data using private key
-    string getEncryptedData() const { return encryptedData; }
+    uint32_t getDifficultyTarget() const { return difficultyTarget; }
+    Digest getTarget() const { return Digest::fromCompact(difficultyTarget); }
+    double getTimestamp() const { return timestamp; }
+    string getData() const;  // Decrypts data using private key (once; memoized)
+    const string& getEncryptedData() const { return encryptedData; }
     string getPreviousBlockRef() const { return previousBlockRef; }
-    PublicKey getPublicKey() const { return publicKey; }  // SAFE: only public key
+    const PublicKey& getPublicKey() const { return publicKey; }  // SAFE: only public key
     
     // REMOVED: getKeyPair() - no more private key exposure!
 
     // Setters for deserialization and mining
     void setNonce(int n) { nonce = n; }
-    void setEncryptedData(const string& encrypted) { encryptedData = encrypted; }
+    void setDifficultyTarget(uint32_t compact) { difficultyTarget = compact; }
+    void setTimestamp(double time) { timestamp = time; }
+    void setEncryptedData(const string& encrypted) { encryptedData = encrypted; decryptedValid = false; }
     void setPublicKey(const PublicKey& pubKey) { publicKey = pubKey; }
     void setPublicSessionKeyHash(const string& hash) { publicSessionKeyHash = hash; }
     
     // Mining-related methods
-    string calculateMiningHash() const;
-    bool isMinedValid(int difficulty) const;
+    string getMiningHeaderPrefix() const;              // Nonce-independent part of the PoW input
+    string getMiningHashInput(int miningNonce) const;  // Header bytes hashed for PoW
+    Digest calculateMiningHash() const;
+    bool isMinedValid() const;                          // Against the header's own target
+    bool isMinedValid(int difficultyBits) const;
+    static vector<bool> isMinedValidBatch(const vector<const Block*>& blocks);
 
     // Validation
     bool isValidBlock() const;
 
     // Block identifier based on encrypted content
     string getBlockIdentifier() const;
+    static string makeIdentifier(int blockNumber, int nonce, const char* encrypted, size_t encryptedSize);
 
-    // SECURE serialization - no private keys transmitted
+    // SECURE serialization - no private keys transmitted. serialize() writes the
+    // binary wire format (BlockWireHeader); deserialize() accepts it or the text form.
     string serialize() const;
+    void serializeTo(string& out) const;   // Replaces out, reusing its capacity
     static Block deserialize(const string& serialized);
+    static void deserialize(const char* data, size_t size, Block& into);  // Binary only
+
+    // Legacy '|'-separated text format
+    string serializeText() const;
+    static Block deserializeText(const string& serialized);
     
 private:
     // Generate hash of session key for verification
     string generateSessionKeyHash(long long sessionKey) const;
+
+    friend class BlockView;
+};
+
+// Read-only view of a binary serialized block: the header is decoded, the
+// variable-length fields are pointers into the caller's buffer (which must
+// outlive the view), and nothing is copied until copyTo().
+class BlockView {
+private:
+    BlockWireHeader header;
+    const char* prevRef;
+    const char* sessionHash;
+    const char* body;
+
+public:
+    BlockView() : header(), prevRef(nullptr), sessionHash(nullptr), body(nullptr) {}
+
+    // Throws invalid_argument for a truncated, oversized or non-binary buffer
+    static BlockView parse(const char* data, size_t size);
+    static BlockView parse(const string& data) { return parse(data.data(), data.size()); }
+    static bool isBinary(const string& data) { return !data.empty() && (uint8_t)data[0] == BlockWireHeader::MAGIC; }
+
+    int getBlockNumber() const { return header.blockNumber; }
+    int getNonce() const { return header.nonce; }
+    string getBlockIdentifier() const {
+        return Block::makeIdentifier(header.blockNumber, header.nonce, body, header.bodyLength);
+    }
+    uint32_t getDifficultyTarget() const { return header.difficultyTarget; }
+    double getTimestamp() const { return header.timestamp; }
+    PublicKey getPublicKey() const;  // Builds the key's reduction context
+
+    const char* getPreviousBlockRef() const { return prevRef; }
+    size_t getPreviousBlockRefSize() const { return header.prevRefLength; }
+    const char* getSessionKeyHash() const { return sessionHash; }
+    size_t getSessionKeyHashSize() const { return header.sessionHashLength; }
+    const char* getEncryptedData() const { return body; }
+    size_t getEncryptedDataSize() const { return header.bodyLength; }
+
+    // Overwrites block with the public fields, reusing its string capacity;
+    // the private key material is cleared, as for any remote block
+    void copyTo(Block& block) const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef BLOCKPAYLOAD_H
+#define BLOCKPAYLOAD_H
+
+#include <omnetpp.h>
+#include <string>
+
+using namespace omnetpp;
+using namespace std;
+
+// Serialized block carried on a proposal message. Block bytes are binary
+// (ciphertext and key limbs contain NULs), so they travel as an owned object
+// rather than a string cPar, which only holds C strings.
+class BlockPayload : public cOwnedObject {
+private:
+    string bytes;
+
+public:
+    BlockPayload(const char *name, const string &data) : cOwnedObject(name), bytes(data) {}
+    BlockPayload(const BlockPayload &other) : cOwnedObject(other), bytes(other.bytes) {}
+
+    virtual BlockPayload *dup() const override { return new BlockPayload(*this); }
+
+    const string &getBytes() const { return bytes; }
+};
+
+#endif
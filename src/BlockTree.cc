@@ -0,0 +1,251 @@
+#include "BlockTree.h"
+#include "DifficultyController.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_set>
+
+using namespace std;
+
+BlockTreeStats::BlockTreeStats()
+    : blocksAdded(0), sideBlocks(0), reorgs(0), reorgBlocksUndone(0), maxReorgDepth(0), lastReorgDepth(0),
+      orphansReceived(0), orphansDropped(0), staleRejected(0), invalidRejected(0), prunedBlocks(0) {}
+
+BlockTree::BlockTree(Blockchain& activeChain, size_t depth)
+    : chain(activeChain), pruneDepth(depth < 1 ? 1 : depth), orphanArrivals(0) {
+    resync();
+}
+
+double BlockTree::blockWork(const Block& block) {
+    return exp2(DifficultyController::difficultyBits(block.getDifficultyTarget()));
+}
+
+void BlockTree::resync() {
+    sideBlocks.clear();
+    orphans.clear();
+    chainWork.clear();
+    chainWork.reserve(chain.getChainLength());
+    double work = 0.0;
+    for (const Block& block : chain.getChain()) {
+        work += blockWork(block);
+        chainWork.push_back(work);
+    }
+}
+
+bool BlockTree::contains(const string& identifier) const {
+    return chain.contains(identifier) || sideBlocks.count(identifier) != 0 || orphans.count(identifier) != 0;
+}
+
+BlockTreeOutcome BlockTree::addBlock(Block&& block) {
+    string identifier = block.getBlockIdentifier();
+    return addBlock(move(block), identifier);
+}
+
+BlockTreeOutcome BlockTree::addBlock(Block&& block, const string& identifier) {
+    if (contains(identifier)) {
+        return TREE_DUPLICATE;
+    }
+    BlockTreeOutcome outcome = connect(block, identifier);
+    if (outcome == TREE_ORPHAN) {
+        holdOrphan(move(block), identifier);
+    } else if (outcome != TREE_STALE && outcome != TREE_INVALID) {
+        connectOrphans(identifier);
+    }
+    return outcome;
+}
+
+// Leaves block untouched unless it was connected
+BlockTreeOutcome BlockTree::connect(Block& block, const string& identifier) {
+    string parent = block.getPreviousBlockRef();
+    bool extendsTip = parent == chain.getLatestBlockIdentifier();
+
+    size_t parentHeight;
+    double parentWork;
+    vector<const Block*> ancestry;
+    if (chain.findHeight(parent, parentHeight)) {
+        if (!extendsTip && parentHeight + 1 + pruneDepth < chain.getChainLength() - 1) {   // Would be pruned at once
+            stats.staleRejected++;
+            return TREE_STALE;
+        }
+        parentWork = chainWork[parentHeight];
+    } else {
+        auto it = sideBlocks.find(parent);
+        if (it == sideBlocks.end()) {
+            return TREE_ORPHAN;
+        }
+        parentHeight = it->second.height;
+        parentWork = it->second.work;
+        for (; it != sideBlocks.end(); it = sideBlocks.find(it->second.block.getPreviousBlockRef())) {
+            ancestry.push_back(&it->second.block);
+        }
+        reverse(ancestry.begin(), ancestry.end());
+    }
+
+    if (!carriesClaimedWork(block, parentHeight + 1, ancestry)) {
+        stats.invalidRejected++;
+        return TREE_INVALID;
+    }
+    double work = blockWork(block);
+
+    if (extendsTip) {
+        chain.addBlock(move(block));
+        chainWork.push_back(chainWork.back() + work);
+        stats.blocksAdded++;
+        prune();
+        return TREE_EXTENDED;
+    }
+
+    sideBlocks.emplace(identifier, SideBlock{move(block), parentHeight + 1, parentWork + work});
+    stats.blocksAdded++;
+    stats.sideBlocks++;
+
+    // Strictly heavier only: on equal work the branch seen first stays active
+    if (parentWork + work > chainWork.back()) {
+        reorganize(identifier);
+        return TREE_REORGANIZED;
+    }
+    return TREE_SIDE_BRANCH;
+}
+
+bool BlockTree::carriesClaimedWork(const Block& block, size_t height, const vector<const Block*>& ancestry) {
+    // Only the genesis block goes unmined, and it is the root rather than added
+    if (block.getNonce() == 0) {
+        return false;
+    }
+    size_t forkHeight = height - 1 - ancestry.size();
+    uint32_t expected = chain.getDifficultyController().expectedTarget(height, [&](size_t index) -> const Block& {
+        return index <= forkHeight ? *chain.getBlockAt(index) : *ancestry[index - forkHeight - 1];
+    });
+    if (block.getDifficultyTarget() != expected) {
+        return false;
+    }
+    return !chain.requiresProofOfWork() || block.isMinedValid();
+}
+
+// Switches the active chain to the branch ending at tip: undoes the active
+// blocks above the fork point into a side branch, then applies the branch
+void BlockTree::reorganize(const string& tip) {
+    vector<string> branch;
+    string cursor = tip;
+    for (auto it = sideBlocks.find(cursor); it != sideBlocks.end(); it = sideBlocks.find(cursor)) {
+        branch.push_back(cursor);
+        cursor = it->second.block.getPreviousBlockRef();
+    }
+    size_t forkHeight;
+    if (!chain.findHeight(cursor, forkHeight)) {
+        throw runtime_error("Side branch ending at " + tip + " is detached from the chain");
+    }
+    reverse(branch.begin(), branch.end());
+
+    vector<string> undoneIds;
+    for (size_t height = forkHeight + 1; height < chain.getChainLength(); height++) {
+        undoneIds.push_back(chain.getBlockIdentifier(height));
+    }
+    vector<Block> undone = chain.truncate(forkHeight + 1);
+    for (size_t i = 0; i < undone.size(); i++) {
+        size_t height = forkHeight + 1 + i;
+        sideBlocks.emplace(undoneIds[i], SideBlock{move(undone[i]), height, chainWork[height]});
+    }
+    chainWork.resize(forkHeight + 1);
+
+    for (const string& identifier : branch) {
+        auto it = sideBlocks.find(identifier);
+        double work = it->second.work;
+        chain.addBlock(move(it->second.block));
+        chainWork.push_back(work);
+        sideBlocks.erase(it);
+    }
+
+    size_t depth = undone.size();
+    stats.reorgs++;
+    stats.reorgBlocksUndone += depth;
+    stats.maxReorgDepth = max(stats.maxReorgDepth, depth);
+    stats.lastReorgDepth = depth;
+    stats.reorgDepths[depth]++;
+    prune();
+}
+
+void BlockTree::holdOrphan(Block&& block, const string& identifier) {
+    stats.orphansReceived++;
+    if (orphans.size() >= MAX_ORPHANS) {
+        auto oldest = orphans.begin();
+        for (auto it = orphans.begin(); it != orphans.end(); ++it) {
+            if (it->second.arrival < oldest->second.arrival) oldest = it;
+        }
+        orphans.erase(oldest);
+        stats.orphansDropped++;
+    }
+    orphans.emplace(identifier, Orphan{move(block), orphanArrivals++});
+}
+
+// Connects the orphans descending from parent, each as soon as its own parent is in
+void BlockTree::connectOrphans(const string& parent) {
+    vector<string> connected(1, parent);
+    while (!connected.empty() && !orphans.empty()) {
+        string next = move(connected.back());
+        connected.pop_back();
+
+        vector<string> children;
+        for (const auto& orphan : orphans) {
+            if (orphan.second.block.getPreviousBlockRef() == next) children.push_back(orphan.first);
+        }
+        for (const string& child : children) {
+            auto it = orphans.find(child);
+            Block block = move(it->second.block);
+            orphans.erase(it);
+            BlockTreeOutcome outcome = connect(block, child);
+            if (outcome == TREE_ORPHAN) {
+                stats.orphansDropped++;   // Its parent was pruned meanwhile
+            } else if (outcome != TREE_STALE && outcome != TREE_INVALID) {
+                connected.push_back(child);
+            }
+        }
+    }
+}
+
+// Drops side blocks more than pruneDepth below the active tip, and with them
+// every side block that no longer descends from the tree. Visiting in height
+// order sees each parent before its children.
+void BlockTree::prune() {
+    if (sideBlocks.empty()) {
+        return;
+    }
+    size_t tipHeight = chain.getChainLength() - 1;
+
+    vector<pair<size_t, const string*>> byHeight;
+    byHeight.reserve(sideBlocks.size());
+    for (const auto& side : sideBlocks) {
+        byHeight.emplace_back(side.second.height, &side.first);
+    }
+    sort(byHeight.begin(), byHeight.end(),
+         [](const pair<size_t, const string*>& a, const pair<size_t, const string*>& b) { return a.first < b.first; });
+
+    unordered_set<string> dropped;
+    for (const auto& entry : byHeight) {
+        const SideBlock& side = sideBlocks.at(*entry.second);
+        string parent = side.block.getPreviousBlockRef();
+        bool stale = entry.first + pruneDepth < tipHeight;
+        bool detached = dropped.count(parent) != 0 || (!chain.contains(parent) && sideBlocks.count(parent) == 0);
+        if (stale || detached) dropped.insert(*entry.second);
+    }
+    for (const string& identifier : dropped) {
+        sideBlocks.erase(identifier);
+    }
+    stats.prunedBlocks += dropped.size();
+}
+
+vector<BlockTreeTip> BlockTree::getTips() const {
+    vector<BlockTreeTip> tips;
+    tips.push_back({chain.getLatestBlockIdentifier(), chain.getChainLength() - 1, chainWork.back(), true});
+
+    unordered_set<string> parents;
+    for (const auto& side : sideBlocks) {
+        parents.insert(side.second.block.getPreviousBlockRef());
+    }
+    for (const auto& side : sideBlocks) {
+        if (parents.count(side.first) == 0) {
+            tips.push_back({side.first, side.second.height, side.second.work, false});
+        }
+    }
+    return tips;
+}
@@ -0,0 +1,128 @@
+#ifndef BLOCKTREE_H
+#define BLOCKTREE_H
+
+#include "Block.h"
+#include "Blockchain.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+enum BlockTreeOutcome {
+    TREE_EXTENDED = 0,      // Appended to the active chain's tip
+    TREE_SIDE_BRANCH = 1,   // Kept on a competing branch that is not heavier
+    TREE_REORGANIZED = 2,   // Its branch became the heaviest and the active chain switched to it
+    TREE_ORPHAN = 3,        // Parent not seen yet; held until it arrives
+    TREE_DUPLICATE = 4,     // Already in the tree
+    TREE_STALE = 5,         // Forks deeper than the prune depth; discarded
+    TREE_INVALID = 6        // Does not carry the work its branch requires; discarded
+};
+
+struct BlockTreeStats {
+    size_t blocksAdded;          // Connected to the tree (active chain or a side branch)
+    size_t sideBlocks;           // Of those, blocks that did not extend the active tip on arrival
+    size_t reorgs;
+    size_t reorgBlocksUndone;    // Active blocks switched out over all reorgs
+    size_t maxReorgDepth;
+    size_t lastReorgDepth;
+    map<size_t, size_t> reorgDepths;   // Depth -> reorgs of that depth
+    size_t orphansReceived;
+    size_t orphansDropped;       // Evicted before their parent arrived
+    size_t staleRejected;
+    size_t invalidRejected;      // Unmined, off-target or failing proof of work
+    size_t prunedBlocks;
+
+    BlockTreeStats();
+    double forkRate() const { return blocksAdded > 0 ? (double)sideBlocks / blocksAdded : 0.0; }
+    double meanReorgDepth() const { return reorgs > 0 ? (double)reorgBlocksUndone / reorgs : 0.0; }
+};
+
+struct BlockTreeTip {
+    string identifier;
+    size_t height;
+    double work;        // Cumulative expected hashes from genesis
+    bool active;
+};
+
+// Fork-aware layer over a Blockchain, which holds the active (heaviest) chain.
+// Blocks that do not extend the active tip are kept by identifier on side
+// branches, each with the cumulative work of the branch up to it. When a side
+// tip carries strictly more work than the active tip the tree reorganizes:
+// the active chain is truncated back to the fork point, the undone blocks
+// become a side branch, and the winning branch's blocks are appended. Only the
+// differing suffix moves.
+//
+// A block is only credited with work it provably carries: it must be mined
+// (nonzero nonce), declare exactly the target the difficulty controller
+// expects at its height on its own branch, and, when the chain requires proof
+// of work, hash below that target.
+//
+// pruneDepth bounds how far a reorg may reach: side blocks more than that
+// many blocks below the active tip are dropped, and blocks forking from
+// deeper than that are rejected as stale.
+class BlockTree {
+public:
+    static const size_t MAX_ORPHANS = 256;
+
+    explicit BlockTree(Blockchain& chain, size_t pruneDepth = 16);
+
+    // Takes ownership of a block whose parent may be on any branch; any
+    // orphans waiting for it are connected afterwards
+    BlockTreeOutcome addBlock(Block&& block);
+    BlockTreeOutcome addBlock(Block&& block, const string& identifier);
+
+    // Active chain, side branches or the orphan pool
+    bool contains(const string& identifier) const;
+
+    // Drops side branches and orphans and rereads the chain's work; call after
+    // the chain was replaced or reloaded without going through the tree
+    void resync();
+
+    void setPruneDepth(size_t depth) { pruneDepth = depth < 1 ? 1 : depth; }
+    size_t getPruneDepth() const { return pruneDepth; }
+
+    vector<BlockTreeTip> getTips() const;   // Active tip first
+    double getActiveWork() const { return chainWork.back(); }
+    size_t getSideBlockCount() const { return sideBlocks.size(); }
+    size_t getOrphanCount() const { return orphans.size(); }
+    const BlockTreeStats& getStats() const { return stats; }
+
+    // Expected hashes to find a block at its header's target
+    static double blockWork(const Block& block);
+
+private:
+    struct SideBlock {
+        Block block;
+        size_t height;
+        double work;            // Cumulative through this block
+    };
+
+    struct Orphan {
+        Block block;
+        size_t arrival;         // Oldest is evicted first
+    };
+
+    Blockchain& chain;
+    size_t pruneDepth;
+    vector<double> chainWork;   // Cumulative work of the active chain per height
+    unordered_map<string, SideBlock> sideBlocks;
+    unordered_map<string, Orphan> orphans;
+    size_t orphanArrivals;
+    BlockTreeStats stats;
+
+    BlockTree(const BlockTree&) = delete;
+    BlockTree& operator=(const BlockTree&) = delete;
+
+    BlockTreeOutcome connect(Block& block, const string& identifier);
+    // ancestry: side blocks between the active chain and the block's parent, oldest first
+    bool carriesClaimedWork(const Block& block, size_t height, const vector<const Block*>& ancestry);
+    void reorganize(const string& tip);
+    void holdOrphan(Block&& block, const string& identifier);
+    void connectOrphans(const string& parent);
+    void prune();
+};
+
+#endif
@@ -1,68 +1,464 @@
-#ifndef BLOCK_H
-#define BLOCK_H
-#include <string>
-#include <sstream>
+#include "Blockchain.h"
+#include "KeyPool.h"
+#include <omnetpp.h>
 #include <iomanip>
-#include "ElGamal.h"
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
 
+using namespace omnetpp;
 using namespace std;
 
-class Block {
-private:
-    int blockNumber;
-    int nonce;
-    string data;                    // Original data (never transmitted)
-    string encryptedData;          // Encrypted data for transmission
-    string previousBlockRef;
-    KeyPair keyPair;              // PRIVATE - never transmitted
-    PublicKey publicKey;          // PUBLIC - safe for transmission
-    long long sessionKey;         // PRIVATE - never transmitted
-    string publicSessionKeyHash;  // PUBLIC - hash of session key for verification
-
-public:
-    // Default constructor for container compatibility
-    Block() : blockNumber(0), nonce(0), sessionKey(0) {}
-    
-    // Main constructor
-    Block(int blockNum, const string& blockData, const string& prevRef);
-
-    // Copy constructor and assignment operator
-    Block(const Block& other) = default;
-    Block& operator=(const Block& other) = default;
-
-    // Getters
-    int getBlockNumber() const { return blockNumber; }
-    int getNonce() const { return nonce; }
-    string getData() const;  // Decrypts data using private key
-    string getEncryptedData() const { return encryptedData; }
-    string getPreviousBlockRef() const { return previousBlockRef; }
-    PublicKey getPublicKey() const { return publicKey; }  // SAFE: only public key
-    
-    // REMOVED: getKeyPair() - no more private key exposure!
-
-    // Setters for deserialization and mining
-    void setNonce(int n) { nonce = n; }
-    void setEncryptedData(const string& encrypted) { encryptedData = encrypted; }
-    void setPublicKey(const PublicKey& pubKey) { publicKey = pubKey; }
-    void setPublicSessionKeyHash(const string& hash) { publicSessionKeyHash = hash; }
-    
-    // Mining-related methods
-    string calculateMiningHash() const;
-    bool isMinedValid(int difficulty) const;
-
-    // Validation
-    bool isValidBlock() const;
-
-    // Block identifier based on encrypted content
-    string getBlockIdentifier() const;
-
-    // SECURE serialization - no private keys transmitted
-    string serialize() const;
-    static Block deserialize(const string& serialized);
-    
-private:
-    // Generate hash of session key for verification
-    string generateSessionKeyHash(long long sessionKey) const;
-};
-
-#endif
\ No newline at end of file
+namespace {
+
+void appendUint32(string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back((char)(value >> (8 * i)));
+    }
+}
+
+// Proof-of-work digests are computed this many headers at a time (multi-buffer SHA-256)
+const size_t POW_BATCH = 64;
+
+uint32_t readUint32(const string& in, size_t pos) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= (uint32_t)(unsigned char)in[pos + i] << (8 * i);
+    }
+    return value;
+}
+
+} // namespace
+
+Blockchain::Blockchain()
+    : length(0), validatedHeight(0), requireProofOfWork(true),
+      validationThreads(max(1u, thread::hardware_concurrency())) {
+    append(createGenesisBlock());
+}
+
+// Fixed key material makes the genesis ciphertext, and so its identifier, the
+// same on every node: all branches of every replica share this root
+Block Blockchain::createGenesisBlock() {
+    KeyMaterial material;
+    material.keyPair = ElGamal::generateKeyPair(2147483647LL, 2, 1234567);
+    material.sessionKey = 7654321;
+    return Block(0, "Genesis Block", "0", material);
+}
+
+bool Blockchain::append(Block&& block) {
+    string identifier = block.getBlockIdentifier();
+    return append(move(block), move(identifier));
+}
+
+bool Blockchain::append(Block&& block, string identifier) {
+    if (heightById.count(identifier) != 0) {
+        return false;
+    }
+    if (store) {
+        store->append(block.serialize());   // Written through before it becomes visible
+    }
+
+    if (length % SEGMENT_BLOCKS == 0) {
+        unique_ptr<Segment> segment(new Segment());
+        segment->blocks.reserve(SEGMENT_BLOCKS);
+        segment->identifiers.reserve(SEGMENT_BLOCKS);
+        segments.push_back(move(segment));
+    }
+    Segment& segment = *segments.back();
+    segment.blocks.push_back(move(block));
+    auto inserted = heightById.emplace(move(identifier), length);
+    segment.identifiers.push_back(&inserted.first->first);
+    length++;
+    return true;
+}
+
+void Blockchain::clear() {
+    segments.clear();
+    heightById.clear();
+    length = 0;
+    validatedHeight = 0;
+    if (store) {
+        store->reset();
+    }
+}
+
+void Blockchain::materialize(size_t segmentIndex) const {
+    Segment& segment = *segments[segmentIndex];
+    size_t first = segmentIndex * SEGMENT_BLOCKS;
+    size_t count = min(SEGMENT_BLOCKS, length - first);
+
+    segment.blocks.reserve(SEGMENT_BLOCKS);
+    segment.blocks.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        if (!store->verify(first + i)) {
+            throw runtime_error("Stored block " + to_string(first + i) + " fails its checksum");
+        }
+        size_t size;
+        const char* data = store->record(first + i, size);
+        Block::deserialize(data, size, segment.blocks[i]);
+    }
+    segment.materialized = true;
+}
+
+void Blockchain::materializeAll() const {
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (!segments[i]->materialized) materialize(i);
+    }
+}
+
+size_t Blockchain::getMaterializedBlocks() const {
+    size_t blocks = 0;
+    for (const unique_ptr<Segment>& segment : segments) {
+        blocks += segment->materialized ? segment->blocks.size() : 0;
+    }
+    return blocks;
+}
+
+void Blockchain::openStorage(const string& directory, size_t syncInterval) {
+    unique_ptr<ChainStore> opened(new ChainStore(directory, SEGMENT_BLOCKS, syncInterval));
+    if (opened->size() == 0) {
+        // Nothing stored yet: write this chain out and keep appending to it
+        materializeAll();
+        for (const Block& block : getChain()) {
+            opened->append(block.serialize());
+        }
+        opened->sync();
+        store = move(opened);
+        return;
+    }
+
+    // Adopt the stored chain. Only identifiers are derived up front, from views
+    // of the mapped records; blocks are parsed a segment at a time when used.
+    size_t stored = opened->size();
+    vector<unique_ptr<Segment>> adopted;
+    unordered_map<string, size_t> index;
+    index.reserve(stored);
+    for (size_t height = 0; height < stored; height++) {
+        if (height % SEGMENT_BLOCKS == 0) {
+            unique_ptr<Segment> segment(new Segment());
+            segment->identifiers.reserve(SEGMENT_BLOCKS);
+            segment->materialized = false;
+            adopted.push_back(move(segment));
+        }
+        size_t size;
+        const char* data = opened->record(height, size);
+        auto inserted = index.emplace(BlockView::parse(data, size).getBlockIdentifier(), height);
+        if (!inserted.second) {
+            throw runtime_error("Stored chain in " + directory + " repeats block " + inserted.first->first);
+        }
+        adopted.back()->identifiers.push_back(&inserted.first->first);
+    }
+
+    segments = move(adopted);
+    heightById = move(index);
+    length = stored;
+    validatedHeight = 0;   // Nothing read from disk is trusted until revalidated
+    store = move(opened);
+
+    // Appends continue the last segment in memory
+    if (length % SEGMENT_BLOCKS != 0) {
+        materialize(segments.size() - 1);
+    }
+}
+
+void Blockchain::closeStorage() {
+    materializeAll();
+    store.reset();
+}
+
+ChainStoreStats Blockchain::getStorageStats() const {
+    return store ? store->getStats() : ChainStoreStats();
+}
+
+// Local blocks: encrypted under fresh key material, linked to the current tip
+bool Blockchain::addBlock(const string& data) {
+    Block block(length, data, getLatestBlockIdentifier());
+    block.setDifficultyTarget(getExpectedDifficulty(length));
+    return append(move(block));
+}
+
+bool Blockchain::addBlock(const Block& block) {
+    return append(Block(block));
+}
+
+// Remote blocks: kept byte-for-byte as received, no re-keying or re-encryption
+bool Blockchain::addBlock(Block&& block) {
+    return append(move(block));
+}
+
+Block* Blockchain::getLatestBlock() {
+    return &blockAt(length - 1);
+}
+
+Block* Blockchain::getBlockAt(size_t index) {
+    return index < length ? &blockAt(index) : nullptr;
+}
+
+const Block* Blockchain::getBlockAt(size_t index) const {
+    return index < length ? &blockAt(index) : nullptr;
+}
+
+const string& Blockchain::getBlockIdentifier(size_t height) const {
+    return *segments[height / SEGMENT_BLOCKS]->identifiers[height % SEGMENT_BLOCKS];
+}
+
+const Block* Blockchain::findBlock(const string& identifier) const {
+    auto it = heightById.find(identifier);
+    return it == heightById.end() ? nullptr : &blockAt(it->second);
+}
+
+bool Blockchain::findHeight(const string& identifier, size_t& height) const {
+    auto it = heightById.find(identifier);
+    if (it == heightById.end()) {
+        return false;
+    }
+    height = it->second;
+    return true;
+}
+
+ChainView Blockchain::getChain(size_t from, size_t to) const {
+    to = min(to, length);
+    return ChainView(this, min(from, to), to);
+}
+
+void Blockchain::setRequireProofOfWork(bool required) {
+    if (required != requireProofOfWork) {
+        requireProofOfWork = required;
+        validatedHeight = 0;
+    }
+}
+
+size_t Blockchain::validateRange(size_t from, size_t to) const {
+    size_t firstInvalid = to;
+    vector<const Block*> batch;
+    vector<size_t> heights;
+    batch.reserve(POW_BATCH);
+    heights.reserve(POW_BATCH);
+
+    auto checkBatch = [&]() {
+        vector<bool> mined = Block::isMinedValidBatch(batch);
+        for (size_t i = 0; i < mined.size(); i++) {
+            if (!mined[i]) firstInvalid = min(firstInvalid, heights[i]);
+        }
+        batch.clear();
+        heights.clear();
+    };
+
+    for (size_t height = from; height < firstInvalid; height++) {
+        const Block& block = blockAt(height);
+        if (block.getEncryptedData().empty() ||
+            (height > from && block.getPreviousBlockRef() != getBlockIdentifier(height - 1))) {
+            firstInvalid = height;
+            break;
+        }
+        // Only the genesis block goes unmined, as BlockTree requires of every other
+        if (height > 0 && block.getNonce() == 0) {
+            firstInvalid = height;
+            break;
+        }
+        if (requireProofOfWork && height > 0) {
+            batch.push_back(&block);
+            heights.push_back(height);
+            if (batch.size() == POW_BATCH) checkBatch();
+        }
+    }
+    if (!batch.empty()) checkBatch();
+    return firstInvalid;
+}
+
+// Splits [from, length) into one contiguous range per worker. Ranges after the
+// first start on segment boundaries, so each segment is materialized by exactly
+// one worker. Each worker checks its range independently; the links between
+// ranges are then stitched in order, and the first failure found wins.
+size_t Blockchain::validateFrom(size_t from, int threads) const {
+    if (from >= length) {
+        return length;
+    }
+    size_t firstSegment = from / SEGMENT_BLOCKS;
+    size_t spanned = (length - 1) / SEGMENT_BLOCKS - firstSegment + 1;
+    size_t workers = min((size_t)max(threads, 1), spanned);
+
+    vector<size_t> starts(workers + 1);
+    starts[0] = from;
+    starts[workers] = length;
+    for (size_t w = 1; w < workers; w++) {
+        starts[w] = (firstSegment + spanned * w / workers) * SEGMENT_BLOCKS;
+    }
+
+    // A stored block that fails its checksum invalidates the range it sits in
+    vector<size_t> failures(workers);
+    auto check = [&](size_t w) {
+        try {
+            failures[w] = validateRange(starts[w], starts[w + 1]);
+        } catch (const exception&) {
+            failures[w] = starts[w];
+        }
+    };
+    if (workers == 1) {
+        check(0);
+    } else {
+        vector<thread> pool;
+        for (size_t w = 0; w < workers; w++) {
+            pool.emplace_back(check, w);
+        }
+        for (thread& worker : pool) {
+            worker.join();
+        }
+    }
+
+    size_t firstInvalid = length;
+    for (size_t w = 0; w < workers && firstInvalid == length; w++) {
+        size_t start = starts[w];
+        if (failures[w] == start ||
+            (start > 0 && blockAt(start).getPreviousBlockRef() != getBlockIdentifier(start - 1))) {
+            firstInvalid = start;
+        } else if (failures[w] < starts[w + 1]) {
+            firstInvalid = failures[w];
+        }
+    }
+
+    // Each expected target depends on the blocks before it, so targets are checked
+    // here, in height order, over the prefix the workers found intact
+    for (size_t height = max(from, (size_t)1); height < firstInvalid; height++) {
+        if (blockAt(height).getDifficultyTarget() != getExpectedDifficulty(height)) {
+            return height;
+        }
+    }
+    return firstInvalid;
+}
+
+// Every block must name its predecessor's identifier, carry a payload, be mined
+// (genesis aside), declare the target the difficulty controller expects at its
+// height and, when required, meet that target. Heights below validatedHeight
+// were checked by an earlier call and are skipped.
+bool Blockchain::isChainValid() const {
+    validatedHeight = validateFrom(validatedHeight, validationThreads);
+    return validatedHeight == length;
+}
+
+bool Blockchain::revalidateChain(int threads) const {
+    validatedHeight = validateFrom(0, threads > 0 ? threads : validationThreads);
+    return validatedHeight == length;
+}
+
+// Longest-chain rule: adopt a strictly longer, well-linked chain
+bool Blockchain::replaceChain(const vector<Block>& newChain) {
+    if (newChain.size() <= length) {
+        return false;
+    }
+    for (size_t i = 1; i < newChain.size(); i++) {
+        if (newChain[i].getPreviousBlockRef() != newChain[i - 1].getBlockIdentifier()) {
+            return false;
+        }
+    }
+
+    clear();
+    for (const Block& block : newChain) {
+        append(Block(block));
+    }
+    return true;
+}
+
+vector<Block> Blockchain::truncate(size_t height) {
+    height = max(height, (size_t)1);
+    vector<Block> removed;
+    if (height >= length) {
+        return removed;
+    }
+
+    // Removed blocks are moved out, and a partly kept segment must be in memory for appends
+    for (size_t segment = height / SEGMENT_BLOCKS; segment < segments.size(); segment++) {
+        if (!segments[segment]->materialized) materialize(segment);
+    }
+    if (store) {
+        store->truncate(height);
+    }
+
+    removed.reserve(length - height);
+    for (size_t h = height; h < length; h++) {
+        removed.push_back(move(blockAt(h)));
+        heightById.erase(heightById.find(getBlockIdentifier(h)));   // Not erase(key): the key is the node's own
+    }
+    segments.resize((height + SEGMENT_BLOCKS - 1) / SEGMENT_BLOCKS);
+    Segment& last = *segments.back();
+    last.blocks.resize(height - (segments.size() - 1) * SEGMENT_BLOCKS);
+    last.identifiers.resize(last.blocks.size());
+
+    length = height;
+    validatedHeight = min(validatedHeight, length);
+    return removed;
+}
+
+// For a chain whose genesis itself cannot be trusted, which truncate() keeps
+void Blockchain::resetToGenesis() {
+    clear();
+    append(createGenesisBlock());
+}
+
+void Blockchain::displayChain() const {
+    EV << "\n=== BLOCKCHAIN (" << length << " blocks) ===\n";
+    for (size_t i = 0; i < length; i++) {
+        const Block& block = blockAt(i);
+        EV << "Block " << setw(4) << block.getBlockNumber()
+           << " | nonce " << setw(10) << block.getNonce()
+           << " | id " << getBlockIdentifier(i)
+           << " | prev " << block.getPreviousBlockRef() << "\n";
+    }
+    EV << "================================\n";
+}
+
+// Block count, then each block's wire bytes behind a 4-byte length
+string Blockchain::serialize() const {
+    string out;
+    appendUint32(out, (uint32_t)length);
+    string bytes;
+    for (const Block& block : getChain()) {
+        block.serializeTo(bytes);
+        appendUint32(out, (uint32_t)bytes.size());
+        out.append(bytes);
+    }
+    return out;
+}
+
+void Blockchain::deserialize(const string& serialized) {
+    if (serialized.size() < 4) {
+        throw invalid_argument("Serialized chain is missing its block count");
+    }
+    size_t count = readUint32(serialized, 0);
+    if (count == 0) {
+        throw invalid_argument("Serialized chain has no genesis block");
+    }
+    if (count > (serialized.size() - 4) / (4 + BlockWireHeader::SIZE)) {
+        throw invalid_argument("Serialized chain is shorter than its block count");
+    }
+
+    // Parse everything before touching the current chain
+    vector<Block> blocks(count);
+    size_t pos = 4;
+    for (size_t i = 0; i < count; i++) {
+        if (pos + 4 > serialized.size()) {
+            throw invalid_argument("Serialized chain is truncated");
+        }
+        size_t blockBytes = readUint32(serialized, pos);
+        pos += 4;
+        if (pos + blockBytes > serialized.size()) {
+            throw invalid_argument("Serialized block overruns the chain");
+        }
+        Block::deserialize(serialized.data() + pos, blockBytes, blocks[i]);
+        pos += blockBytes;
+    }
+
+    vector<string> identifiers(count);
+    unordered_set<string> seen;
+    for (size_t i = 0; i < count; i++) {
+        identifiers[i] = blocks[i].getBlockIdentifier();
+        if (!seen.insert(identifiers[i]).second) {
+            throw invalid_argument("Serialized chain repeats a block");
+        }
+    }
+
+    clear();
+    for (size_t i = 0; i < count; i++) {
+        append(move(blocks[i]), move(identifiers[i]));
+    }
+}
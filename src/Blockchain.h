@@ -2,32 +2,162 @@
 #define BLOCKCHAIN_H
 
 #include "Block.h"
+#include "ChainStore.h"
+#include "DifficultyController.h"
 #include <vector>
 #include <memory>
 #include <sstream>
+#include <unordered_map>
 
 using namespace std;
 
+class Blockchain;
+
+// Read-only range of heights [from, to) over a Blockchain. Iterating yields
+// const Block& straight out of the chain's segments; nothing is copied. Valid
+// until the chain is replaced (appends leave existing blocks where they are).
+class ChainView {
+private:
+    const Blockchain* chain;
+    size_t from, to;
+
+public:
+    class iterator {
+    private:
+        const Blockchain* chain;
+        size_t height;
+    public:
+        iterator(const Blockchain* c, size_t h) : chain(c), height(h) {}
+        const Block& operator*() const;
+        iterator& operator++() { height++; return *this; }
+        bool operator!=(const iterator& other) const { return height != other.height; }
+    };
+
+    ChainView(const Blockchain* c, size_t begin, size_t end) : chain(c), from(begin), to(end) {}
+
+    size_t size() const { return to - from; }
+    bool empty() const { return to == from; }
+    const Block& operator[](size_t index) const;
+    iterator begin() const { return iterator(chain, from); }
+    iterator end() const { return iterator(chain, to); }
+};
+
+// Append-only block store. Blocks live in fixed-capacity segments that are
+// never reallocated, so a height maps to (segment, slot) in O(1) and block
+// addresses stay stable as the chain grows. A hash index maps each block
+// identifier to its height; identifiers are computed once, on append.
+//
+// With storage attached (openStorage) every append is also written to a
+// ChainStore. A chain adopted from disk starts with only its identifiers
+// indexed; each segment is parsed from the mapped files on first access.
+//
+// Validation is incremental: the chain remembers how many leading blocks it
+// has already checked and isChainValid() only looks at the suffix appended
+// since. Blocks must not be modified through getBlockAt() once validated.
 class Blockchain {
+public:
+    static const size_t SEGMENT_BLOCKS = 4096;
+
 private:
-    vector<unique_ptr<Block>> chain;
+    struct Segment {
+        vector<Block> blocks;               // reserve()d to SEGMENT_BLOCKS up front
+        vector<const string*> identifiers;  // Keys of heightById (node keys never move)
+        bool materialized = true;           // false: blocks still only in the ChainStore mapping
+    };
+
+    vector<unique_ptr<Segment>> segments;
+    unordered_map<string, size_t> heightById;
+    size_t length;
+    unique_ptr<ChainStore> store;
+    DifficultyController difficultyController;
+
+    // Leading heights known valid; only ever moves forward between resets
+    mutable size_t validatedHeight;
+    bool requireProofOfWork;
+    int validationThreads;
+
     Block createGenesisBlock();
 
+    // Appends without touching the difficulty; false if the identifier is already indexed
+    bool append(Block&& block);
+    bool append(Block&& block, string identifier);
+    void clear();   // Also empties the attached store
+
+    // Parses a stored segment's blocks out of the mapping (throws runtime_error on a bad checksum)
+    void materialize(size_t segment) const;
+    void materializeAll() const;
+
+    Segment& segmentAt(size_t height) const {
+        Segment& segment = *segments[height / SEGMENT_BLOCKS];
+        if (!segment.materialized) materialize(height / SEGMENT_BLOCKS);
+        return segment;
+    }
+    Block& blockAt(size_t height) { return segmentAt(height).blocks[height % SEGMENT_BLOCKS]; }
+    const Block& blockAt(size_t height) const { return segmentAt(height).blocks[height % SEGMENT_BLOCKS]; }
+
+    // Checks payloads, nonces, proof of work and the links inside [from, to); the link
+    // from `from` back to its predecessor is left to the caller. Returns the
+    // first failing height, or `to`.
+    size_t validateRange(size_t from, size_t to) const;
+    size_t validateFrom(size_t from, int threads) const;
+
 public:
     Blockchain();
 
-    void addBlock(const string& data);
-    void addBlock(const Block& block);  // NEW: Add existing block
+    // Each returns false (and leaves the chain unchanged) for a block already in the chain
+    bool addBlock(const string& data);
+    bool addBlock(const Block& block);  // NEW: Add existing block
+    bool addBlock(Block&& block);       // Take ownership of a validated remote block as received
     Block* getLatestBlock();
-    Block* getBlockAt(size_t index);   // NEW: Get block by index
-    bool isChainValid() const;
+    Block* getBlockAt(size_t index);   // NEW: Get block by index; nullptr past the tip
+    const Block* getBlockAt(size_t index) const;
+    bool isChainValid() const;   // Checks only blocks past getValidatedHeight()
+
+    // Lookup by identifier through the hash index
+    const Block* findBlock(const string& identifier) const;
+    bool findHeight(const string& identifier, size_t& height) const;
+    bool contains(const string& identifier) const { return heightById.count(identifier) != 0; }
+    const string& getBlockIdentifier(size_t height) const;  // Cached; height must be < length
+    const string& getLatestBlockIdentifier() const { return getBlockIdentifier(length - 1); }
+
+    // Forgets what has been validated and checks every block, splitting the
+    // chain into contiguous ranges across `threads` workers (0: use the setting)
+    bool revalidateChain(int threads = 0) const;
+    size_t getValidatedHeight() const { return validatedHeight; }
+    void setValidationThreads(int threads) { validationThreads = threads < 1 ? 1 : threads; }
+    int getValidationThreads() const { return validationThreads; }
+    // Simulated mining carries modelled nonces, so nodes running it skip the hash check
+    void setRequireProofOfWork(bool required);
+    bool requiresProofOfWork() const { return requireProofOfWork; }
 
     // Network synchronization methods
-    vector<Block> getChain() const;
+    ChainView getChain() const { return ChainView(this, 0, length); }
+    ChainView getChain(size_t from, size_t to) const;  // Clamped to [0, length)
     bool replaceChain(const vector<Block>& newChain);
+    // Removes heights >= height (at least 1, keeping genesis) and returns their
+    // blocks oldest first; the attached store is cut back with them
+    vector<Block> truncate(size_t height);
+    void resetToGenesis();   // Drops every block, genesis included, and starts over from a fresh genesis
 
     // Getters
-    size_t getChainLength() const { return chain.size(); }
+    size_t getChainLength() const { return length; }
+
+    // Difficulty retargeting: compact target a block at `height` (<= chain length) must carry
+    DifficultyController& getDifficultyController() { return difficultyController; }
+    uint32_t getExpectedDifficulty(size_t height) const {
+        return difficultyController.expectedTarget(height, [this](size_t index) -> const Block& {
+            return blockAt(index);
+        });
+    }
+
+    // Persistence: adopts the chain stored in directory, or writes this chain there
+    // if it holds none; appends are then written through and made durable every
+    // syncInterval blocks (see ChainStore). Throws runtime_error.
+    void openStorage(const string& directory, size_t syncInterval = 1);
+    void closeStorage();   // Parses any still-mapped blocks, then detaches
+    bool hasStorage() const { return store != nullptr; }
+    ChainStoreStats getStorageStats() const;   // All zero without storage
+    size_t getMaterializedBlocks() const;
 
     // Display methods
     void displayChain() const;  // NEW: Display entire chain
@@ -35,6 +165,12 @@ public:
     // Serialization for network transmission
     string serialize() const;
     void deserialize(const string& serialized);
+
+    friend class ChainView;
+    friend class ChainView::iterator;
 };
 
-#endif
\ No newline at end of file
+inline const Block& ChainView::iterator::operator*() const { return chain->blockAt(height); }
+inline const Block& ChainView::operator[](size_t index) const { return chain->blockAt(from + index); }
+
+#endif
@@ -0,0 +1,100 @@
+#include "ChaCha20.h"
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+inline uint32_t rotl(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+inline uint32_t loadLE32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline void storeLE32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+#define QUARTER_ROUND(a, b, c, d)              \
+    a += b; d ^= a; d = rotl(d, 16);           \
+    c += d; b ^= c; b = rotl(b, 12);           \
+    a += b; d ^= a; d = rotl(d, 8);            \
+    c += d; b ^= c; b = rotl(b, 7);
+
+// "expand 32-byte k", key words, counter, nonce words
+void initState(uint32_t state[16], const uint8_t* key, const uint8_t* nonce, uint32_t counter) {
+    state[0] = 0x61707865;
+    state[1] = 0x3320646e;
+    state[2] = 0x79622d32;
+    state[3] = 0x6b206574;
+    for (int i = 0; i < 8; i++) {
+        state[4 + i] = loadLE32(key + 4 * i);
+    }
+    state[12] = counter;
+    for (int i = 0; i < 3; i++) {
+        state[13 + i] = loadLE32(nonce + 4 * i);
+    }
+}
+
+// 20 rounds (10 column + diagonal double rounds) plus the feed-forward
+void keystreamBlock(const uint32_t state[16], uint8_t out[ChaCha20::BLOCK_SIZE]) {
+    uint32_t x[16];
+    memcpy(x, state, sizeof(x));
+    for (int round = 0; round < 10; round++) {
+        QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+        QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+        QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+        QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+        QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; i++) {
+        storeLE32(out + 4 * i, x[i] + state[i]);
+    }
+}
+
+#undef QUARTER_ROUND
+
+} // namespace
+
+void ChaCha20::block(const uint8_t key[KEY_SIZE], const uint8_t nonce[NONCE_SIZE], uint32_t counter,
+                     uint8_t out[BLOCK_SIZE]) {
+    uint32_t state[16];
+    initState(state, key, nonce, counter);
+    keystreamBlock(state, out);
+}
+
+void ChaCha20::apply(const uint8_t key[KEY_SIZE], const uint8_t nonce[NONCE_SIZE], uint32_t counter,
+                     const uint8_t* in, uint8_t* out, size_t length) {
+    uint32_t state[16];
+    initState(state, key, nonce, counter);
+
+    uint8_t keystream[BLOCK_SIZE];
+    size_t offset = 0;
+    while (offset < length) {
+        keystreamBlock(state, keystream);
+        state[12]++;
+
+        size_t chunk = length - offset < BLOCK_SIZE ? length - offset : BLOCK_SIZE;
+        if (chunk == BLOCK_SIZE) {
+            // Full block: XOR eight bytes at a time
+            for (size_t i = 0; i < BLOCK_SIZE; i += 8) {
+                uint64_t a, k;
+                memcpy(&a, in + offset + i, 8);
+                memcpy(&k, keystream + i, 8);
+                a ^= k;
+                memcpy(out + offset + i, &a, 8);
+            }
+        } else {
+            for (size_t i = 0; i < chunk; i++) {
+                out[offset + i] = in[offset + i] ^ keystream[i];
+            }
+        }
+        offset += chunk;
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef CHACHA20_H
+#define CHACHA20_H
+
+#include <cstdint>
+#include <cstddef>
+
+// RFC 8439 ChaCha20 stream cipher (256-bit key, 96-bit nonce, 32-bit block counter).
+// Encryption and decryption are the same operation: XOR with the keystream.
+class ChaCha20 {
+public:
+    static const size_t KEY_SIZE = 32;
+    static const size_t NONCE_SIZE = 12;
+    static const size_t BLOCK_SIZE = 64;
+
+    // One 64-byte keystream block for the given counter
+    static void block(const uint8_t key[KEY_SIZE], const uint8_t nonce[NONCE_SIZE], uint32_t counter,
+                      uint8_t out[BLOCK_SIZE]);
+
+    // XOR length bytes of keystream, starting at block `counter`, from in to out (in == out allowed).
+    // A key/nonce pair must never encrypt two different messages.
+    static void apply(const uint8_t key[KEY_SIZE], const uint8_t nonce[NONCE_SIZE], uint32_t counter,
+                      const uint8_t* in, uint8_t* out, size_t length);
+};
+
+#endif
@@ -0,0 +1,456 @@
+#include "ChainStore.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const char INDEX_MAGIC[8] = {'C', 'H', 'A', 'I', 'N', 'I', 'D', 'X'};
+
+// CRC-32 (IEEE 802.3, reflected, as zlib computes it)
+struct Crc32Table {
+    uint32_t entry[256];
+    Crc32Table() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            entry[i] = c;
+        }
+    }
+};
+
+uint32_t crc32(const char* data, size_t size) {
+    static const Crc32Table table;   // Built once, thread-safely
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < size; i++) {
+        crc = table.entry[(crc ^ (unsigned char)data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xffffffffu;
+}
+
+void storeLE(char* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out[i] = (char)(value >> (8 * i));
+    }
+}
+
+uint64_t loadLE(const char* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        value |= (uint64_t)(unsigned char)in[i] << (8 * i);
+    }
+    return value;
+}
+
+runtime_error ioError(const string& what, const string& path) {
+    return runtime_error(what + " " + path + ": " + strerror(errno));
+}
+
+void writeAll(int fd, const char* data, size_t size, uint64_t offset, const string& path) {
+    while (size > 0) {
+        ssize_t written = pwrite(fd, data, size, (off_t)offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw ioError("Cannot write", path);
+        }
+        data += written;
+        size -= (size_t)written;
+        offset += (uint64_t)written;
+    }
+}
+
+bool readAll(int fd, char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t got = pread(fd, data, size, (off_t)offset);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        data += got;
+        size -= (size_t)got;
+        offset += (uint64_t)got;
+    }
+    return true;
+}
+
+// -1 if the file does not exist
+long long fileSize(const string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? (long long)info.st_size : -1;
+}
+
+} // namespace
+
+ChainStore::ChainStore(const string& dir, size_t blocksPerSegment, size_t blocksPerSync)
+    : directory(dir), segmentBlocks(blocksPerSegment), syncInterval(max(blocksPerSync, (size_t)1)),
+      storedBlocks(0), mappedBlocks(0),
+      recoveredBlocks(0), droppedBlocks(0), openSeconds(0.0), indexMapping{nullptr, 0},
+      indexFd(-1), segmentFd(-1), segmentFdIndex(0), segmentOffset(0) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw ioError("Cannot create chain directory", directory);
+    }
+    string indexPath = directory + "/index.dat";
+    indexFd = open(indexPath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (indexFd < 0) {
+        throw ioError("Cannot open", indexPath);
+    }
+
+    char header[INDEX_HEADER_SIZE];
+    long long indexBytes = fileSize(indexPath);
+    if (indexBytes < (long long)INDEX_HEADER_SIZE) {
+        // New (or torn before its header was complete): nothing can be stored yet
+        memcpy(header, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        storeLE(header + 8, VERSION, 4);
+        storeLE(header + 12, segmentBlocks, 4);
+        writeAll(indexFd, header, sizeof(header), 0, indexPath);
+        if (ftruncate(indexFd, INDEX_HEADER_SIZE) != 0) {
+            close(indexFd);
+            throw ioError("Cannot truncate", indexPath);
+        }
+        indexBytes = INDEX_HEADER_SIZE;
+    } else if (!readAll(indexFd, header, sizeof(header), 0) || memcmp(header, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+               loadLE(header + 8, 4) != VERSION || loadLE(header + 12, 4) != segmentBlocks) {
+        close(indexFd);
+        throw runtime_error("Chain index " + indexPath + " has a different format or segment size");
+    }
+
+    size_t entries = ((size_t)indexBytes - INDEX_HEADER_SIZE) / INDEX_ENTRY_SIZE;
+    try {
+        storedBlocks = recover(entries);
+        mapFiles();
+    } catch (...) {
+        unmapFiles();
+        close(indexFd);
+        throw;
+    }
+    recoveredBlocks = storedBlocks;
+    droppedBlocks = entries - storedBlocks;
+    openSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+ChainStore::~ChainStore() {
+    try {
+        sync();
+    } catch (const exception&) {
+        // The unsynced batch is lost, as after a crash; recovery handles it
+    }
+    unmapFiles();
+    if (segmentFd >= 0) close(segmentFd);
+    if (indexFd >= 0) close(indexFd);
+}
+
+string ChainStore::segmentPath(size_t segment) const {
+    char name[48];
+    snprintf(name, sizeof(name), "/segment-%06zu.dat", segment);
+    return directory + name;
+}
+
+void ChainStore::readEntry(size_t height, uint64_t& offset, uint32_t& length, uint32_t& checksum) const {
+    char entry[INDEX_ENTRY_SIZE];
+    const char* bytes = entry;
+    size_t firstPending = storedBlocks - pendingIndex.size() / INDEX_ENTRY_SIZE;
+    if (height >= firstPending && height < storedBlocks) {
+        bytes = pendingIndex.data() + (height - firstPending) * INDEX_ENTRY_SIZE;
+    } else if (height < mappedBlocks) {
+        bytes = indexMapping.data + INDEX_HEADER_SIZE + height * INDEX_ENTRY_SIZE;
+    } else if (!readAll(indexFd, entry, sizeof(entry), INDEX_HEADER_SIZE + height * INDEX_ENTRY_SIZE)) {
+        throw runtime_error("Cannot read chain index entry " + to_string(height));
+    }
+    offset = loadLE(bytes, 8);
+    length = (uint32_t)loadLE(bytes + 8, 4);
+    checksum = (uint32_t)loadLE(bytes + 12, 4);
+}
+
+// Leading heights of [first, end), all in one segment, whose records sit back
+// to back from the segment's start and pass their checksums
+size_t ChainStore::intactPrefix(size_t first, size_t end) const {
+    string path = segmentPath(first / segmentBlocks);
+    long long size = fileSize(path);
+    string bytes(size > 0 ? (size_t)size : 0, '\0');
+    int fd = open(path.c_str(), O_RDONLY);
+    bool readable = fd >= 0 && readAll(fd, &bytes[0], bytes.size(), 0);
+    if (fd >= 0) close(fd);
+    if (!readable) {
+        return first;
+    }
+
+    uint64_t expected = 0;
+    if (first % segmentBlocks != 0) {
+        uint32_t length, checksum;
+        readEntry(first - 1, expected, length, checksum);
+        expected += length;
+    }
+    size_t height = first;
+    for (; height < end; height++) {
+        uint64_t offset;
+        uint32_t length, checksum;
+        readEntry(height, offset, length, checksum);
+        if (offset != expected || offset + length > bytes.size() || crc32(bytes.data() + offset, length) != checksum) {
+            break;
+        }
+        expected = offset + length;
+    }
+    return height;
+}
+
+// Number of leading index entries whose blocks are intact; both files are cut
+// back to them. Every record of the last segment is checked, not just the
+// tail, and a segment with no intact record sends the check to the one before.
+size_t ChainStore::recover(size_t entries) {
+    size_t valid = 0;
+    if (entries > 0) {
+        size_t start = (entries - 1) / segmentBlocks * segmentBlocks;
+        valid = intactPrefix(start, entries);
+        while (valid == start && start > 0) {
+            size_t previous = start - segmentBlocks;
+            size_t intact = intactPrefix(previous, start);
+            if (intact == start) break;
+            start = previous;
+            valid = intact;
+        }
+    }
+
+    // Cut the index, the last segment file, and any segment files past it
+    string indexPath = directory + "/index.dat";
+    if (ftruncate(indexFd, (off_t)(INDEX_HEADER_SIZE + valid * INDEX_ENTRY_SIZE)) != 0) {
+        throw ioError("Cannot truncate", indexPath);
+    }
+    size_t segments = (valid + segmentBlocks - 1) / segmentBlocks;
+    if (valid > 0) {
+        uint64_t offset;
+        uint32_t length, checksum;
+        readEntry(valid - 1, offset, length, checksum);
+        string path = segmentPath(segments - 1);
+        if (::truncate(path.c_str(), (off_t)(offset + length)) != 0) {
+            throw ioError("Cannot truncate", path);
+        }
+    }
+    for (size_t segment = segments; fileSize(segmentPath(segment)) >= 0; segment++) {
+        unlink(segmentPath(segment).c_str());
+    }
+    return valid;
+}
+
+void ChainStore::mapFiles() {
+    size_t indexBytes = INDEX_HEADER_SIZE + storedBlocks * INDEX_ENTRY_SIZE;
+    void* index = mmap(nullptr, indexBytes, PROT_READ, MAP_SHARED, indexFd, 0);
+    if (index == MAP_FAILED) {
+        throw ioError("Cannot map", directory + "/index.dat");
+    }
+    indexMapping = {(const char*)index, indexBytes};
+
+    size_t segments = (storedBlocks + segmentBlocks - 1) / segmentBlocks;
+    for (size_t segment = 0; segment < segments; segment++) {
+        string path = segmentPath(segment);
+        int fd = open(path.c_str(), O_RDONLY);
+        long long size = fileSize(path);
+        if (fd < 0 || size <= 0) {
+            if (fd >= 0) close(fd);
+            throw ioError("Cannot open", path);
+        }
+        void* data = mmap(nullptr, (size_t)size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);   // The mapping keeps the file referenced
+        if (data == MAP_FAILED) {
+            throw ioError("Cannot map", path);
+        }
+        segmentMappings.push_back({(const char*)data, (size_t)size});
+    }
+    mappedBlocks = storedBlocks;
+}
+
+void ChainStore::unmapFiles() {
+    for (const Mapping& mapping : segmentMappings) {
+        munmap((void*)mapping.data, mapping.size);
+    }
+    segmentMappings.clear();
+    if (indexMapping.data) {
+        munmap((void*)indexMapping.data, indexMapping.size);
+        indexMapping = {nullptr, 0};
+    }
+    mappedBlocks = 0;
+}
+
+const char* ChainStore::record(size_t height, size_t& length) const {
+    if (height >= mappedBlocks) {
+        throw out_of_range("Block " + to_string(height) + " is not in the mapped chain store");
+    }
+    uint64_t offset;
+    uint32_t size, checksum;
+    readEntry(height, offset, size, checksum);
+    const Mapping& mapping = segmentMappings[height / segmentBlocks];
+    if (offset + size > mapping.size) {
+        throw runtime_error("Chain index entry " + to_string(height) + " points past its segment");
+    }
+    length = size;
+    return mapping.data + offset;
+}
+
+bool ChainStore::verify(size_t height) const {
+    uint64_t offset;
+    uint32_t length, checksum;
+    readEntry(height, offset, length, checksum);
+    size_t size;
+    const char* data = record(height, size);
+    return crc32(data, size) == checksum;
+}
+
+void ChainStore::openSegmentForAppend(size_t segment, uint64_t offset) {
+    if (segmentFd >= 0) {
+        // Its data may still be waiting on a batch sync
+        if (!pendingIndex.empty() && fdatasync(segmentFd) != 0) {
+            throw ioError("Cannot sync", segmentPath(segmentFdIndex));
+        }
+        close(segmentFd);
+        segmentFd = -1;
+    }
+    string path = segmentPath(segment);
+    segmentFd = open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (segmentFd < 0) {
+        throw ioError("Cannot open", path);
+    }
+    segmentFdIndex = segment;
+    segmentOffset = offset;
+}
+
+void ChainStore::append(const string& wire) {
+    size_t segment = storedBlocks / segmentBlocks;
+    if (segmentFd < 0 || segmentFdIndex != segment) {
+        uint64_t offset = 0;
+        if (storedBlocks % segmentBlocks != 0) {
+            // Continuing the segment that was partly written before this store was opened
+            uint32_t length, checksum;
+            readEntry(storedBlocks - 1, offset, length, checksum);
+            offset += length;
+        }
+        openSegmentForAppend(segment, offset);
+    }
+
+    // Data first; the index entry that makes it visible waits for sync()
+    writeAll(segmentFd, wire.data(), wire.size(), segmentOffset, segmentPath(segment));
+    char entry[INDEX_ENTRY_SIZE];
+    storeLE(entry, segmentOffset, 8);
+    storeLE(entry + 8, wire.size(), 4);
+    storeLE(entry + 12, crc32(wire.data(), wire.size()), 4);
+    pendingIndex.append(entry, sizeof(entry));
+
+    segmentOffset += wire.size();
+    storedBlocks++;
+    if (pendingIndex.size() >= syncInterval * INDEX_ENTRY_SIZE) {
+        sync();
+    }
+}
+
+void ChainStore::sync() {
+    if (pendingIndex.empty()) {
+        return;
+    }
+    if (segmentFd >= 0 && fdatasync(segmentFd) != 0) {
+        throw ioError("Cannot sync", segmentPath(segmentFdIndex));
+    }
+    string indexPath = directory + "/index.dat";
+    size_t firstPending = storedBlocks - pendingIndex.size() / INDEX_ENTRY_SIZE;
+    writeAll(indexFd, pendingIndex.data(), pendingIndex.size(), INDEX_HEADER_SIZE + firstPending * INDEX_ENTRY_SIZE,
+             indexPath);
+    if (fdatasync(indexFd) != 0) {
+        throw ioError("Cannot sync", indexPath);
+    }
+    pendingIndex.clear();
+}
+
+void ChainStore::truncate(size_t height) {
+    if (height >= storedBlocks) {
+        return;
+    }
+    sync();
+    if (height == 0) {
+        reset();
+        return;
+    }
+
+    // Entries are contiguous within a segment, so the first dropped block's
+    // offset is where its segment file now ends
+    uint64_t offset;
+    uint32_t length, checksum;
+    readEntry(height, offset, length, checksum);
+
+    // Mappings of segments that no longer hold any block are released; a kept
+    // mapping may extend past the cut but is only read below mappedBlocks
+    size_t keptSegments = (height + segmentBlocks - 1) / segmentBlocks;
+    while (segmentMappings.size() > keptSegments) {
+        munmap((void*)segmentMappings.back().data, segmentMappings.back().size);
+        segmentMappings.pop_back();
+    }
+    mappedBlocks = min(mappedBlocks, height);
+    if (segmentFd >= 0) {
+        close(segmentFd);
+        segmentFd = -1;
+    }
+
+    string indexPath = directory + "/index.dat";
+    if (ftruncate(indexFd, (off_t)(INDEX_HEADER_SIZE + height * INDEX_ENTRY_SIZE)) != 0) {
+        throw ioError("Cannot truncate", indexPath);
+    }
+    size_t segment = height / segmentBlocks;
+    if (height % segmentBlocks != 0) {
+        string path = segmentPath(segment);
+        if (::truncate(path.c_str(), (off_t)offset) != 0) {
+            throw ioError("Cannot truncate", path);
+        }
+        segment++;
+    }
+    for (; fileSize(segmentPath(segment)) >= 0; segment++) {
+        unlink(segmentPath(segment).c_str());
+    }
+    storedBlocks = height;
+}
+
+void ChainStore::reset() {
+    pendingIndex.clear();
+    unmapFiles();
+    if (segmentFd >= 0) {
+        close(segmentFd);
+        segmentFd = -1;
+    }
+    if (ftruncate(indexFd, INDEX_HEADER_SIZE) != 0) {
+        throw ioError("Cannot truncate", directory + "/index.dat");
+    }
+    for (size_t segment = 0; fileSize(segmentPath(segment)) >= 0; segment++) {
+        unlink(segmentPath(segment).c_str());
+    }
+    storedBlocks = 0;
+}
+
+ChainStoreStats ChainStore::getStats() const {
+    ChainStoreStats stats;
+    stats.storedBlocks = storedBlocks;
+    stats.recoveredBlocks = recoveredBlocks;
+    stats.droppedBlocks = droppedBlocks;
+    stats.segmentFiles = (storedBlocks + segmentBlocks - 1) / segmentBlocks;
+    stats.mappedBytes = 0;
+    for (const Mapping& mapping : segmentMappings) {
+        stats.mappedBytes += mapping.size;
+    }
+    stats.openSeconds = openSeconds;
+    return stats;
+}
+
+void ChainStore::remove(const string& dir) {
+    for (size_t segment = 0;; segment++) {
+        char name[48];
+        snprintf(name, sizeof(name), "/segment-%06zu.dat", segment);
+        if (unlink((dir + name).c_str()) != 0) break;
+    }
+    unlink((dir + "/index.dat").c_str());
+    rmdir(dir.c_str());
+}
@@ -0,0 +1,108 @@
+#ifndef CHAINSTORE_H
+#define CHAINSTORE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct ChainStoreStats {
+    size_t storedBlocks;        // Blocks on disk after recovery and any appends
+    size_t recoveredBlocks;     // Blocks found intact when the store was opened
+    size_t droppedBlocks;       // Torn or corrupt tail entries discarded on open
+    size_t segmentFiles;
+    size_t mappedBytes;         // Segment bytes reachable through the read mappings
+    double openSeconds;         // Open, recovery and mapping time
+};
+
+// Append-only on-disk form of a Blockchain in one directory:
+//
+//   index.dat           16-byte header ("CHAINIDX", version, blocks per segment),
+//                       then one 16-byte entry per height: offset within its
+//                       segment file, length and CRC-32 of the block's wire bytes
+//   segment-NNNNNN.dat  the wire bytes (Block::serialize) of heights
+//                       [N * segmentBlocks, (N + 1) * segmentBlocks), back to back
+//
+// A block is written to its segment file before its index entry, and index
+// entries are written only after the segment data they describe has been
+// fdatasync()ed; the index is synced in turn. Appends are made durable in
+// batches of syncInterval blocks (1: every append), so a power loss can cost
+// at most the last unsynced batch, and only the index tail can be torn.
+// Opening checks every record of the last segment (and, if none of it holds,
+// the segment before) and truncates both files at the first record that is
+// misplaced or fails its checksum. Blocks present at open are read in place
+// through read-only mmaps; nothing is parsed until a caller asks for a record.
+class ChainStore {
+public:
+    static const size_t INDEX_HEADER_SIZE = 16;
+    static const size_t INDEX_ENTRY_SIZE = 16;
+    static const uint32_t VERSION = 1;
+
+    // Creates the directory's files if missing. Throws runtime_error on I/O errors
+    // or an index written with a different version or segment size.
+    ChainStore(const string& directory, size_t segmentBlocks, size_t syncInterval = 1);
+    ~ChainStore();
+
+    size_t size() const { return storedBlocks; }
+    size_t mappedSize() const { return mappedBlocks; }   // Heights readable through record()
+
+    // Wire bytes of a height below mappedSize(), pointing into the mapping (valid
+    // while the store lives and until reset()). verify() checks its CRC-32.
+    const char* record(size_t height, size_t& length) const;
+    bool verify(size_t height) const;
+
+    // Appends the next height; throws runtime_error if the write fails
+    void append(const string& wire);
+    // Makes every append so far durable (data synced, then its index entries)
+    void sync();
+
+    // Drops heights >= height (a chain reorganization undoing its tip); records
+    // below it stay readable. Throws runtime_error if the files cannot be cut.
+    void truncate(size_t height);
+
+    // Drops every block (the files are truncated and the mappings released)
+    void reset();
+
+    ChainStoreStats getStats() const;
+
+    // Deletes a store's files and directory (benchmarks and tests)
+    static void remove(const string& directory);
+
+private:
+    struct Mapping {
+        const char* data;
+        size_t size;
+    };
+
+    string directory;
+    size_t segmentBlocks;
+    size_t syncInterval;
+    string pendingIndex;        // Entries of appended blocks not yet synced, in height order
+    size_t storedBlocks;
+    size_t mappedBlocks;
+    size_t recoveredBlocks;
+    size_t droppedBlocks;
+    double openSeconds;
+
+    Mapping indexMapping;
+    vector<Mapping> segmentMappings;
+    int indexFd;
+    int segmentFd;              // Segment file receiving appends (-1 until needed)
+    size_t segmentFdIndex;
+    uint64_t segmentOffset;     // Bytes in that segment file
+
+    ChainStore(const ChainStore&) = delete;
+    ChainStore& operator=(const ChainStore&) = delete;
+
+    string segmentPath(size_t segment) const;
+    size_t recover(size_t entries);
+    size_t intactPrefix(size_t first, size_t end) const;
+    void mapFiles();
+    void unmapFiles();
+    void openSegmentForAppend(size_t segment, uint64_t offset);
+    void readEntry(size_t height, uint64_t& offset, uint32_t& length, uint32_t& checksum) const;
+};
+
+#endif
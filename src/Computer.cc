@@ -2,11 +2,17 @@
 #include "Computer.h"
 #include "MiningEngine.h"
 #include "HashUtils.h"
+#include "Benchmarks.h"
+#include "BlockPayload.h"
+#include "PrimeGenerator.h"
 #include <sstream>
 #include <map>
 #include <set>
 #include <iomanip>
 #include <algorithm>
+#include <climits>
+#include <chrono>
+#include <sys/stat.h>
 
 using namespace omnetpp;
 using namespace std;
@@ -29,15 +35,122 @@ void Computer::initialize()
     byzantineDetected = 0;
 
     // Initialize mining components
-    miningDifficulty = 4; // 4 leading zeros required
+    miningDifficulty = HashUtils::DEFAULT_DIFFICULTY_BITS; // Initial leading zero bits; retargeted per block
     miningEnabled = true;
     blocksMined = 0;
     totalMiningTime = 0.0;
     totalMiningAttempts = 0;
 
+    simulatedMining = strcmp(par("miningModel").stringValue(), "simulated") == 0;
+    hashRate = par("hashRate").doubleValue();
+    verifyWithRealHash = par("verifyWithRealHash").boolValue();
+    miningDoneTimer = new cMessage("miningDone");
+    pendingBlock = nullptr;
+
+    miningSliceNonces = par("miningSliceNonces").intValue();
+    miningSliceTimer = new cMessage("miningSlice");
+    activeMining = nullptr;
+
+    payloadFormat = strcmp(par("payloadEncryption").stringValue(), "elgamal") == 0 ? FORMAT_BINARY : FORMAT_HYBRID;
+
+    // Prime moduli must be settled before the key pool starts drawing from them
+    const char *primeFile = par("primeFile").stringValue();
+    if (primeFile[0] != '\0')
+    {
+        try
+        {
+            if (PrimeGenerator::loadOrGenerateParameters(primeFile, par("primeCount").intValue(), par("primeBits").intValue()))
+            {
+                EV << "🔢 Generated " << PrimeGenerator::getPrimes().size() << " safe primes into " << primeFile << "\n";
+            }
+        }
+        catch (const invalid_argument &e)
+        {
+            EV << "⚠️  " << e.what() << ", keeping the built-in prime table\n";
+        }
+    }
+
+    // Block key material comes from the shared pool; identical settings on every node are a no-op
+    KeyPool::instance().configure(par("keyPoolCapacity").intValue(), par("keyPoolLowWater").intValue(),
+                                  (unsigned long long)par("keyPoolSeed").intValue());
+
+    // Difficulty retargeting from observed block intervals
+    DifficultyController &difficulty = blockchain.getDifficultyController();
+    difficulty.setInitialDifficulty(miningDifficulty);
+    difficulty.setTargetBlockInterval(par("targetBlockInterval").doubleValue());
+    difficulty.setRetargetInterval(par("retargetInterval").intValue());
+    difficulty.setWindowSize(par("lwmaWindow").intValue());
+    try
+    {
+        difficulty.setAlgorithm(DifficultyController::parseAlgorithm(par("retargetAlgorithm").stringValue()));
+    }
+    catch (const invalid_argument &e)
+    {
+        EV << "⚠️  " << e.what() << ", keeping fixed difficulty\n";
+        difficulty.setAlgorithm(RETARGET_FIXED);
+    }
+
+    // Simulated blocks carry modelled nonces that would not pass a hash check
+    blockchain.setRequireProofOfWork(!simulatedMining);
+    if (par("validationThreads").intValue() > 0)
+        blockchain.setValidationThreads(par("validationThreads").intValue());
+    blockTree.setPruneDepth(par("forkPruneDepth").intValue());
+
+    // Persisted chain: resume from <chainDirectory>/node-<id>, or start writing one there
+    const char *chainDirectory = par("chainDirectory").stringValue();
+    if (chainDirectory[0] != '\0')
+    {
+        try
+        {
+            mkdir(chainDirectory, 0755);
+            blockchain.openStorage(string(chainDirectory) + "/node-" + to_string(nodeId));
+            blockTree.resync();
+            ChainStoreStats stored = blockchain.getStorageStats();
+            EV << "📂 Chain storage: " << stored.recoveredBlocks << " blocks resumed in "
+               << fixed << setprecision(1) << stored.openSeconds * 1000.0 << " ms, "
+               << stored.droppedBlocks << " torn blocks dropped\n";
+
+            // Resumed blocks are revalidated once, in parallel; later checks only see new blocks.
+            // A chain that fails is cut back to its valid prefix, in memory and on disk, so
+            // nothing is mined or served on top of a bad block.
+            if (stored.recoveredBlocks > 0)
+            {
+                auto start = chrono::steady_clock::now();
+                bool valid = blockchain.revalidateChain();
+                double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                if (valid)
+                    EV << "✅ Resumed chain revalidated: " << blockchain.getChainLength() << " blocks on "
+                       << blockchain.getValidationThreads() << " threads in " << fixed << setprecision(1)
+                       << seconds * 1000.0 << " ms\n";
+                else
+                {
+                    size_t validHeight = blockchain.getValidatedHeight();
+                    size_t resumedLength = blockchain.getChainLength();
+                    if (validHeight > 0)
+                        blockchain.truncate(validHeight);
+                    else
+                        blockchain.resetToGenesis();   // Not even the stored genesis holds
+                    blockTree.resync();
+                    EV << "⚠️  Resumed chain fails validation at height " << validHeight << ": cut back to "
+                       << blockchain.getChainLength() << " blocks, " << resumedLength - blockchain.getChainLength()
+                       << " dropped\n";
+                }
+            }
+        }
+        catch (const exception &e)
+        {
+            EV << "⚠️  " << e.what() << ", keeping the chain in memory only\n";
+        }
+    }
+
     miningEngine.setDifficulty(miningDifficulty);
     miningEngine.setMaxAttempts(50000); // Limit for simulation
     miningEngine.setShowProgress(true);
+    miningEngine.setOwnerId(nodeId);
+    miningEngine.setPriority((MiningPriority)par("miningPriority").intValue());
+    miningEngine.setThreadCount(par("miningThreads").intValue());
+    miningEngine.setNonceSplit(strcmp(par("nonceSplit").stringValue(), "interleaved") == 0
+                                   ? SPLIT_INTERLEAVED : SPLIT_CHUNKED);
 
     // Initialize all node reputations to neutral (0.5)
     for (int i = 0; i < totalNodes; i++)
@@ -87,6 +200,11 @@ void Computer::initialize()
     if (nodeId == 0)
     {
         fuzzySystem.printFuzzyRules();
+
+        if (par("runBenchmarks").boolValue())
+        {
+            Benchmarks::runAll();
+        }
     }
 }
 
@@ -104,6 +222,14 @@ void Computer::handleMessage(cMessage *msg)
             double nextInterval = par("miningInterval").doubleValue() * uniform(0.7, 1.3);
             scheduleAt(simTime() + nextInterval, blockTimer);
         }
+        else if (msg == miningDoneTimer)
+        {
+            completeSimulatedMining();
+        }
+        else if (msg == miningSliceTimer)
+        {
+            continueSlicedMining();
+        }
         return;
     }
 
@@ -159,6 +285,14 @@ void Computer::createNewBlock()
 
     if (nodeType == HONEST)
     {
+        if (pendingBlock || activeMining)
+        {
+            EV << "⏳ Node " << nodeId << " still mining block "
+               << (pendingBlock ? pendingBlock->getBlockNumber() : activeMining->block.getBlockNumber())
+               << " - skipping new block creation\n";
+            return;
+        }
+
         EV << "🚀 Node " << nodeId << " starting block creation and mining...\n";
         try
         {
@@ -189,11 +323,28 @@ void Computer::mineAndBroadcastBlock(const std::string &blockData)
     {
         // Step 1: Create block with encrypted data
         Block newBlock(blockchain.getChainLength(), blockData,
-                       blockchain.getLatestBlock()->getBlockIdentifier());
+                       blockchain.getLatestBlockIdentifier(), payloadFormat);
+
+        // Header carries the retargeted difficulty for this height and the seal time
+        newBlock.setDifficultyTarget(blockchain.getExpectedDifficulty(blockchain.getChainLength()));
+        newBlock.setTimestamp(simTime().dbl());
+        miningEngine.setTarget(newBlock.getTarget());
 
         EV << "📦 Block created with encrypted data\n";
         displayBlockData(newBlock, "CREATED");
 
+        if (simulatedMining)
+        {
+            startSimulatedMining(newBlock);
+            return;
+        }
+
+        if (miningSliceNonces > 0)
+        {
+            startSlicedMining(newBlock);
+            return;
+        }
+
         // Step 2: Mine the block (find golden nonce)
         EV << "\n🔨 STARTING MINING PROCESS...\n";
         EV << "=================================\n";
@@ -203,35 +354,168 @@ void Computer::mineAndBroadcastBlock(const std::string &blockData)
         // Step 3: Handle mining result
         if (result.success)
         {
-            // Mining successful!
-            blocksMined++;
-            totalMiningTime += result.miningTimeMs;
-            totalMiningAttempts += result.attempts;
+            publishMinedBlock(newBlock, result.attempts, result.miningTimeMs);
+        }
+        else
+        {
+            // Mining failed
+            EV << "❌ MINING FAILED!\n";
+            EV << "=================================\n";
+            EV << "Could not find golden nonce within attempt limit\n\n";
 
-            EV << "✅ MINING SUCCESSFUL!\n";
-            EV << "=================================\n\n";
+            updateNodeReputation(nodeId, false);
+        }
+    }
+    catch (const exception &e)
+    {
+        EV << "❌ Error in mining process for node " << nodeId << ": " << e.what() << "\n";
+    }
+}
 
-            // Add mined block to local blockchain
-            blockchain.addBlock(newBlock);
+// Record, append and broadcast a block whose golden nonce has been found
+void Computer::publishMinedBlock(Block &block, long long attempts, double miningTimeMs)
+{
+    // Mining successful!
+    blocksMined++;
+    totalMiningTime += miningTimeMs;
+    totalMiningAttempts += attempts;
 
-            // Display mined block
-            displayBlockData(newBlock, "MINED");
+    EV << "✅ MINING SUCCESSFUL!\n";
+    EV << "=================================\n\n";
 
-            // Broadcast mined block
-            if (shouldBroadcast())
-            {
-                broadcastNewBlockSequentially(newBlock.serialize());
-            }
+    // Add mined block to local blockchain (a side branch if the tip moved while mining)
+    blockTree.addBlock(Block(block));
 
-            updateNodeReputation(nodeId, true);
+    // Display mined block
+    displayBlockData(block, "MINED");
+
+    // Broadcast mined block
+    if (shouldBroadcast())
+    {
+        broadcastNewBlockSequentially(block.serialize());
+    }
+
+    updateNodeReputation(nodeId, true);
+
+    EV << "🎉 HONEST Node " << nodeId << " successfully mined block "
+       << blockchain.getChainLength() << " (nonce: " << block.getNonce()
+       << ", attempts: " << attempts << ")\n\n";
+}
+
+// Simulated hashpower: with H hashes/s and an expected 2^256/(target+1) attempts,
+// the time to the first golden nonce is exponential with mean attempts/H. The
+// discovery is delivered as a self-message, so simulated time advances while
+// mining and no CPU is spent on the nonce search.
+void Computer::startSimulatedMining(const Block &block)
+{
+    double expectedAttempts = miningEngine.getExpectedAttempts();
+    double meanTime = expectedAttempts / hashRate;
+    double discoveryDelay = exponential(meanTime);
+
+    pendingBlock = new Block(block);
+    miningStartTime = simTime();
+    scheduleAt(simTime() + discoveryDelay, miningDoneTimer);
+
+    EV << "🎲 Simulated mining of block " << block.getBlockNumber() << " at "
+       << hashRate << " H/s (expected " << expectedAttempts << " attempts, mean "
+       << meanTime << " s, discovery in " << discoveryDelay << " s)\n";
+}
+
+void Computer::completeSimulatedMining()
+{
+    if (!pendingBlock)
+        return;
+
+    double elapsed = (simTime() - miningStartTime).dbl();
+    long long attempts = max(1LL, (long long)(elapsed * hashRate));
+
+    // The nonce stands in for the work done; it is not a real golden nonce
+    pendingBlock->setNonce((int)min<long long>(attempts, INT_MAX));
+    pendingBlock->setTimestamp(simTime().dbl()); // Sealed at discovery, which drives retargeting
+
+    // The nonce is moved up from the modelled attempt count to the first one whose header
+    // hash meets the reduced difficulty, so receivers can check the header was really hashed
+    if (verifyWithRealHash)
+    {
+        int firstNonce = (int)min<long long>(attempts, INT_MAX - 65536);
+        pendingBlock->setNonce(firstNonce);
+        while (!pendingBlock->isMinedValid(SIMULATED_PROOF_BITS) && pendingBlock->getNonce() < INT_MAX)
+            pendingBlock->setNonce(pendingBlock->getNonce() + 1);
+        EV << "🔍 Real nonce " << pendingBlock->getNonce() << " meets " << SIMULATED_PROOF_BITS << " zero bits after "
+           << (long long)pendingBlock->getNonce() - firstNonce + 1 << " header hashes\n";
+    }
+
+    Block block = *pendingBlock;
+    delete pendingBlock;
+    pendingBlock = nullptr;
+
+    try
+    {
+        publishMinedBlock(block, attempts, elapsed * 1000.0);
+    }
+    catch (const exception &e)
+    {
+        EV << "❌ Error publishing simulated block for node " << nodeId << ": " << e.what() << "\n";
+    }
+}
+
+// A competing block for this height was accepted: the pending discovery is stale
+void Computer::abortSimulatedMining(int height)
+{
+    if (!pendingBlock || pendingBlock->getBlockNumber() != height)
+        return;
+
+    cancelEvent(miningDoneTimer);
+    delete pendingBlock;
+    pendingBlock = nullptr;
+
+    EV << "🛑 Node " << nodeId << " abandoned simulated mining of block " << height
+       << " (competing block accepted)\n";
+}
 
-            EV << "🎉 HONEST Node " << nodeId << " successfully mined block "
-               << blockchain.getChainLength() << " (nonce: " << newBlock.getNonce()
-               << ", attempts: " << result.attempts << ")\n\n";
+// Sliced real mining: each miningSlice event stands for the end of a window in
+// which this node hashed miningSliceNonces nonces at hashRate, so the window
+// lasts miningSliceNonces / hashRate of simulated time. Between windows the node
+// handles proposals and votes like any other event, and a competing block at
+// the same height aborts the search before the next window is hashed.
+void Computer::startSlicedMining(const Block &block)
+{
+    EV << "\n🔨 STARTING SLICED MINING PROCESS (" << miningSliceNonces << " nonces per slice)...\n";
+    EV << "=================================\n";
+
+    activeMining = new MiningSession();
+    miningEngine.beginMining(*activeMining, block);
+    miningStartTime = simTime();
+    scheduleAt(simTime() + miningSliceNonces / hashRate, miningSliceTimer);
+}
+
+void Computer::continueSlicedMining()
+{
+    if (!activeMining)
+        return;
+
+    MiningSliceStatus status = miningEngine.mineSlice(*activeMining, miningSliceNonces);
+    if (status == SLICE_PENDING)
+    {
+        scheduleAt(simTime() + miningSliceNonces / hashRate, miningSliceTimer);
+        return;
+    }
+
+    MiningSession session = *activeMining;
+    delete activeMining;
+    activeMining = nullptr;
+
+    EV << "⏱️  Sliced mining of block " << session.block.getBlockNumber() << " ended after "
+       << (simTime() - miningStartTime) << " s simulated, " << session.result.attempts << " attempts\n";
+
+    try
+    {
+        if (status == SLICE_FOUND)
+        {
+            publishMinedBlock(session.block, session.result.attempts, session.result.miningTimeMs);
         }
-        else
+        else if (status == SLICE_EXHAUSTED)
         {
-            // Mining failed
             EV << "❌ MINING FAILED!\n";
             EV << "=================================\n";
             EV << "Could not find golden nonce within attempt limit\n\n";
@@ -241,10 +525,26 @@ void Computer::mineAndBroadcastBlock(const std::string &blockData)
     }
     catch (const exception &e)
     {
-        EV << "❌ Error in mining process for node " << nodeId << ": " << e.what() << "\n";
+        EV << "❌ Error publishing mined block for node " << nodeId << ": " << e.what() << "\n";
     }
 }
 
+// A competing block for this height was accepted: stop hashing a stale header
+void Computer::abortSlicedMining(int height)
+{
+    if (!activeMining || activeMining->block.getBlockNumber() != height)
+        return;
+
+    cancelEvent(miningSliceTimer);
+    miningEngine.abortMining(*activeMining);
+
+    EV << "🛑 Node " << nodeId << " abandoned mining of block " << height << " after "
+       << activeMining->result.attempts << " attempts (competing block accepted)\n";
+
+    delete activeMining;
+    activeMining = nullptr;
+}
+
 // **SEQUENTIAL MESSAGE SENDING - One by One**
 void Computer::broadcastNewBlockSequentially(const string &blockData)
 {
@@ -276,7 +576,7 @@ void Computer::broadcastNewBlockSequentially(const string &blockData)
             }
 
             cMessage *msg = new cMessage("fuzzyBlockProposal");
-            msg->addPar("blockData") = blockData.c_str();
+            msg->addObject(new BlockPayload("blockData", blockData));
             msg->addPar("proposerNode") = nodeId;
             msg->addPar("proposerReputation") = nodeReputations[nodeId];
             msg->addPar("sendOrder") = broadcastCount; // Track send order
@@ -296,7 +596,8 @@ void Computer::broadcastNewBlockSequentially(const string &blockData)
 
 void Computer::handleBlockProposal(cMessage *msg)
 {
-    string blockData = msg->par("blockData").stringValue();
+    BlockPayload *payload = dynamic_cast<BlockPayload *>(msg->getObject("blockData"));
+    string blockData = payload ? payload->getBytes() : string();
     int proposerNode = (int)msg->par("proposerNode").longValue();
     int sendOrder = msg->hasPar("sendOrder") ? (int)msg->par("sendOrder").longValue() : 0;
 
@@ -306,21 +607,24 @@ void Computer::handleBlockProposal(cMessage *msg)
 
     try
     {
-        Block block = Block::deserialize(blockData);
-        string blockId = block.getBlockIdentifier();
+        // Parsed once; digest and structural checks are shared by every stage below
+        ValidatedBlock validated(blockData);
+        const Block &block = validated.getBlock();
+        const string &blockId = validated.getBlockId();
 
         // Display the received block data
-        displayBlockData(block, "RECEIVED");
+        displayBlockData(block, "RECEIVED", &validated);
 
         // **EXECUTE ALL 6 MAMDANI FUZZY STEPS FOR BFT DECISION**
-        bool trustDecision = makeFuzzyBFTDecision(proposerNode, blockData, blockId);
+        bool trustDecision = makeFuzzyBFTDecision(proposerNode, validated);
 
         if (trustDecision)
         {
             blocksAccepted++;
 
-            // Add block to local blockchain immediately upon acceptance
-            addBlockToChain(block);
+            // Add block to local blockchain immediately upon acceptance; local
+            // mining is abandoned there, and only if the block moves the tip
+            addBlockToChain(validated);
 
             EV << "✓ Node " << nodeId << " ACCEPTED and ADDED block from node " << proposerNode
                << " via Fuzzy BFT\n";
@@ -374,7 +678,7 @@ void Computer::handleBlockProposal(cMessage *msg)
 
 // Display detailed block data
 
-void Computer::displayBlockData(const Block &block, const string &action)
+void Computer::displayBlockData(const Block &block, const string &action, const ValidatedBlock *validated)
 {
     EV << "\n╔═══════════════════════════════════════════════════════════╗\n"
        << "║                    BLOCK " << action << " - NODE " << setw(2) << nodeId << "                ║\n"
@@ -401,9 +705,10 @@ void Computer::displayBlockData(const Block &block, const string &action)
     if (block.getNonce() > 0)
     {
         EV << "║ Nonce (Golden)  : " << setw(38) << block.getNonce() << " ║\n";
-        string blockHash = block.calculateMiningHash();
-        EV << "║ Mining Hash     : " << setw(38) << blockHash.substr(0, 35) << "... ║\n";
-        EV << "║ Mining Status   : " << setw(38) << (block.isMinedValid(miningDifficulty) ? "✅ VALID POW" : "❌ INVALID POW") << " ║\n";
+        Digest miningHash = validated ? validated->getMiningHash() : block.calculateMiningHash();
+        bool powValid = miningHash.meetsTarget(block.getTarget());
+        EV << "║ Mining Hash     : " << setw(38) << miningHash.toHex().substr(0, 35) << "... ║\n";
+        EV << "║ Mining Status   : " << setw(38) << (simulatedMining ? "🎲 SIMULATED POW" : (powValid ? "✅ VALID POW" : "❌ INVALID POW")) << " ║\n";
     }
     else
     {
@@ -411,7 +716,10 @@ void Computer::displayBlockData(const Block &block, const string &action)
         EV << "║ Mining Status   : " << setw(38) << "⚠️  NO PROOF-OF-WORK" << " ║\n";
     }
 
+    EV << "║ Difficulty      : " << setw(33) << fixed << setprecision(2)
+       << DifficultyController::difficultyBits(block.getDifficultyTarget()) << " bits ║\n";
     EV << "║ Timestamp       : " << setw(38) << simTime().str() << " ║\n";
+    EV << "║ Sealed At       : " << setw(36) << block.getTimestamp() << " s ║\n";
 
     if (action == "ADDED")
     {
@@ -422,22 +730,64 @@ void Computer::displayBlockData(const Block &block, const string &action)
 }
 
 // **NEW: Add block to blockchain with validation**
-void Computer::addBlockToChain(const Block &block)
+void Computer::addBlockToChain(ValidatedBlock &validated)
 {
     try
     {
-        // Validate block before adding
-        if (block.isValidBlock())
+        // Validate block before adding: memoized structure and PoW, no decryption or rehash
+        if (blockTree.contains(validated.getBlockId()))
         {
-            blockchain.addBlock(block.getData()); // Add using the data
-            displayBlockData(block, "ADDED");
-
-            EV << "Block successfully added to blockchain!\n"
-               << "New blockchain length: " << blockchain.getChainLength() << "\n";
+            EV << "Block already in blockchain - not added again\n";
+            return;
         }
-        else
+        if (!validated.isValid(!simulatedMining))
         {
             EV << "Block validation failed - not added to blockchain\n";
+            return;
+        }
+
+        // Append the received bytes as-is, so replicas hold identical blocks
+        int miningHeight = (int)blockchain.getChainLength();
+        string blockId = validated.getBlockId();
+        int blockNumber = validated.getBlock().getBlockNumber();
+        BlockTreeOutcome outcome = blockTree.addBlock(validated.releaseBlock(), blockId);
+
+        // Only a moved tip makes local mining stale: whatever was being mined now
+        // extends a block that is no longer the tip of the active chain
+        if (outcome == TREE_EXTENDED || outcome == TREE_REORGANIZED)
+        {
+            MiningPool::instance().cancelJobs(nodeId, miningHeight);
+            abortSimulatedMining(miningHeight);
+            abortSlicedMining(miningHeight);
+        }
+
+        switch (outcome)
+        {
+        case TREE_EXTENDED:
+            displayBlockData(*blockchain.getLatestBlock(), "ADDED", &validated);
+            EV << "Block successfully added to blockchain!\n"
+               << "New blockchain length: " << blockchain.getChainLength() << "\n";
+            break;
+        case TREE_REORGANIZED:
+            displayBlockData(*blockchain.getLatestBlock(), "ADDED", &validated);
+            EV << "🔀 Reorganized to a heavier branch, " << blockTree.getStats().lastReorgDepth
+               << " blocks undone. New blockchain length: " << blockchain.getChainLength() << "\n";
+            break;
+        case TREE_SIDE_BRANCH:
+            EV << "Block kept on a side branch (" << blockTree.getSideBlockCount() << " side blocks)\n";
+            break;
+        case TREE_ORPHAN:
+            EV << "Block's parent not seen yet - held as an orphan\n";
+            break;
+        case TREE_STALE:
+            EV << "Block forks more than " << blockTree.getPruneDepth() << " blocks below the tip - discarded\n";
+            break;
+        case TREE_INVALID:
+            EV << "Block does not carry the work expected at height " << blockNumber
+               << " on its branch - discarded\n";
+            break;
+        case TREE_DUPLICATE:
+            break;
         }
     }
     catch (const exception &e)
@@ -473,7 +823,7 @@ void Computer::executeByzantineBehavior(const string &blockData)
                     try
                     {
                         Block fakeBlock(blockchain.getChainLength(), doubleData,
-                                        blockchain.getLatestBlock()->getBlockIdentifier());
+                                        blockchain.getLatestBlockIdentifier(), payloadFormat);
                         displayBlockData(fakeBlock, "BYZANTINE_CREATED");
                         broadcastNewBlockSequentially(fakeBlock.serialize());
                     }
@@ -506,7 +856,7 @@ void Computer::executeByzantineBehavior(const string &blockData)
             try
             {
                 Block corruptBlock(blockchain.getChainLength(), corruptedData,
-                                   blockchain.getLatestBlock()->getBlockIdentifier());
+                                   blockchain.getLatestBlockIdentifier(), payloadFormat);
                 displayBlockData(corruptBlock, "BYZANTINE_CREATED");
                 broadcastNewBlockSequentially(corruptBlock.serialize());
             }
@@ -518,13 +868,13 @@ void Computer::executeByzantineBehavior(const string &blockData)
     }
 }
 
-bool Computer::makeFuzzyBFTDecision(int proposerNode, const string &blockData, const string &blockId)
+bool Computer::makeFuzzyBFTDecision(int proposerNode, const ValidatedBlock &block)
 {
     try
     {
         double nodeReputation = calculateNodeReputation(proposerNode);
-        double blockValidity = calculateBlockValidity(blockData);
-        double networkConsensus = calculateNetworkConsensus(blockId);
+        double blockValidity = calculateBlockValidity(block);
+        double networkConsensus = calculateNetworkConsensus(block.getBlockId());
 
         if (ByzantineNode::isByzantine(nodeType))
         {
@@ -566,28 +916,25 @@ double Computer::calculateNodeReputation(int nodeId)
     return nodeReputations[nodeId];
 }
 
-double Computer::calculateBlockValidity(const string &blockData)
+double Computer::calculateBlockValidity(const ValidatedBlock &validated)
 {
     try
     {
-        Block block = Block::deserialize(blockData);
+        const Block &block = validated.getBlock();
 
         // Basic structural validation
-        if (block.getEncryptedData().empty())
+        ValidatedBlock::PayloadCheck payload = validated.checkPayload();
+        if (payload == ValidatedBlock::PAYLOAD_EMPTY)
             return 0.0;
 
         double validity = 1.0;
-
-        // Check if encrypted data looks valid
-        string encData = block.getEncryptedData();
-        if (encData.find(",") == string::npos || encData.find(";") == string::npos)
+        if (payload != ValidatedBlock::PAYLOAD_OK)
         {
-            validity *= 0.3; // Malformed encrypted data
+            validity *= 0.3; // Malformed ciphertext or values outside the key's group
         }
 
         // Check if public key parameters are reasonable
-        PublicKey pubKey = block.getPublicKey();
-        if (pubKey.p < 1000 || pubKey.e1 < 2 || pubKey.e2 < 2)
+        if (!validated.hasPlausibleKey())
         {
             validity *= 0.2; // Suspicious key parameters
         }
@@ -595,21 +942,58 @@ double Computer::calculateBlockValidity(const string &blockData)
         if (block.getBlockNumber() < 0)
             validity *= 0.3;
 
+        // Difficulty must match the retarget schedule for the height it extends
+        size_t height = blockchain.getChainLength();
+        if ((size_t)block.getBlockNumber() == height)
+        {
+            uint32_t expectedTarget = blockchain.getExpectedDifficulty(height);
+            if (block.getDifficultyTarget() != expectedTarget)
+            {
+                validity *= 0.2;
+                EV << "❌ Block difficulty " << fixed << setprecision(2)
+                   << DifficultyController::difficultyBits(block.getDifficultyTarget())
+                   << " bits does not match expected "
+                   << DifficultyController::difficultyBits(expectedTarget) << " bits\n";
+            }
+        }
+
+        // Timestamps feed the retarget window, so reject blocks from the future
+        if (block.getTimestamp() > simTime().dbl())
+        {
+            validity *= 0.5;
+            EV << "⚠️  Block timestamp " << block.getTimestamp() << " is ahead of local time\n";
+        }
+
         // Mining validation (Proof-of-Work verification)
-        if (block.getNonce() > 0)
+        if (block.getNonce() > 0 && simulatedMining)
+        { // Simulated hashpower: the work is modelled, only a reduced proof is embedded in the digest
+            int zeroBits = verifyWithRealHash ? validated.getMiningHash().leadingZeroBits() : 0;
+            if (verifyWithRealHash && zeroBits < SIMULATED_PROOF_BITS)
+            {
+                validity *= 0.1; // Same penalty as a failed real proof
+                EV << "❌ Simulated block failed its reduced proof-of-work (nonce: " << block.getNonce() << ", "
+                   << zeroBits << "/" << SIMULATED_PROOF_BITS << " zero bits)\n";
+            }
+            else
+            {
+                validity *= 1.2;
+                EV << "🎲 Block carries simulated proof-of-work (" << block.getNonce() << " modelled attempts)\n";
+            }
+        }
+        else if (block.getNonce() > 0)
         { // If block was mined
-            bool miningValid = block.isMinedValid(miningDifficulty);
-            if (!miningValid)
+            int zeroBits = validated.getMiningHash().leadingZeroBits();
+            if (!validated.hasValidProofOfWork())
             {
                 validity *= 0.1; // Severely penalize invalid mining
                 EV << "❌ Block failed mining validation (invalid nonce: "
-                   << block.getNonce() << ")\n";
+                   << block.getNonce() << ", " << zeroBits << "/" << block.getTarget().leadingZeroBits() << " zero bits)\n";
             }
             else
             {
                 validity *= 1.2; // Bonus for valid mining
                 EV << "✅ Block passed mining validation (nonce: "
-                   << block.getNonce() << ")\n";
+                   << block.getNonce() << ", " << zeroBits << " zero bits)\n";
             }
         }
         else
@@ -691,6 +1075,16 @@ bool Computer::shouldBroadcast()
 void Computer::finish()
 {
     cancelAndDelete(blockTimer);
+    cancelAndDelete(miningDoneTimer);
+    delete pendingBlock;
+    pendingBlock = nullptr;
+    cancelAndDelete(miningSliceTimer);
+    if (activeMining)
+    {
+        miningEngine.abortMining(*activeMining);
+        delete activeMining;
+        activeMining = nullptr;
+    }
 
     double avgReputation = 0.0;
     for (auto &pair : nodeReputations)
@@ -738,7 +1132,16 @@ void Computer::finish()
             Block *block = blockchain.getBlockAt(i);
             if (block)
             {
-                EV << "Block " << i << ": " << block->getData().substr(0, 50) << "...\n";
+                try
+                {
+                    string blockData = block->getData(); // Only blocks keyed on this node decrypt
+                    EV << "Block " << i << ": " << blockData.substr(0, 50) << "...\n";
+                }
+                catch (...)
+                {
+                    EV << "Block " << i << ": [ENCRYPTED - " << block->getEncryptedData().size() << " bytes] "
+                       << block->getBlockIdentifier().substr(0, 35) << "...\n";
+                }
             }
         }
         if (blockchain.getChainLength() > 5)
@@ -750,6 +1153,14 @@ void Computer::finish()
 
     // Display mining statistics
     displayMiningStats();
+    displayForkStats();
+
+    // The mining pool is shared by all nodes, so report it once
+    if (nodeId == 0)
+    {
+        displayMiningPoolStats();
+        displayKeyPoolStats();
+    }
 }
 
 // Mining statistics display
@@ -761,7 +1172,10 @@ void Computer::displayMiningStats()
     EV << "\n╔═══════════════════════════════════════════════════════════╗\n"
        << "║                    MINING STATISTICS - NODE " << setw(2) << nodeId << "           ║\n"
        << "╠═══════════════════════════════════════════════════════════╣\n"
-       << "║ Mining Difficulty   : " << setw(38) << miningDifficulty << " ║\n"
+       << "║ Mining Difficulty   : " << setw(33) << fixed << setprecision(2)
+       << DifficultyController::difficultyBits(blockchain.getExpectedDifficulty(blockchain.getChainLength())) << " bits ║\n"
+       << "║ Retarget Algorithm  : " << setw(38) << DifficultyController::algorithmName(blockchain.getDifficultyController().getAlgorithm()) << " ║\n"
+       << "║ Mining Threads      : " << setw(38) << miningEngine.getThreadCount() << " ║\n"
        << "║ Blocks Mined        : " << setw(38) << blocksMined << " ║\n"
        << "║ Total Mining Time   : " << setw(35) << totalMiningTime << " ms ║\n"
        << "║ Total Attempts      : " << setw(38) << totalMiningAttempts << " ║\n";
@@ -778,4 +1192,72 @@ void Computer::displayMiningStats()
     }
 
     EV << "╚═══════════════════════════════════════════════════════════╝\n\n";
+}
+
+// Fork and reorganization statistics of this run
+void Computer::displayForkStats()
+{
+    const BlockTreeStats &stats = blockTree.getStats();
+    string depths;
+    for (const auto &depth : stats.reorgDepths)
+    {
+        depths += (depths.empty() ? "" : " ") + to_string(depth.first) + "x" + to_string(depth.second);
+    }
+
+    EV << "\n╔═══════════════════════════════════════════════════════════╗\n"
+       << "║                     FORK STATISTICS - NODE " << setw(2) << nodeId << "            ║\n"
+       << "╠═══════════════════════════════════════════════════════════╣\n"
+       << "║ Prune Depth         : " << setw(38) << blockTree.getPruneDepth() << " ║\n"
+       << "║ Blocks Added        : " << setw(38) << stats.blocksAdded << " ║\n"
+       << "║ Side-Branch Blocks  : " << setw(38) << stats.sideBlocks << " ║\n"
+       << "║ Fork Rate           : " << setw(37) << fixed << setprecision(2) << stats.forkRate() * 100 << "% ║\n"
+       << "║ Reorgs              : " << setw(38) << stats.reorgs << " ║\n"
+       << "║ Max Reorg Depth     : " << setw(38) << stats.maxReorgDepth << " ║\n"
+       << "║ Mean Reorg Depth    : " << setw(38) << stats.meanReorgDepth() << " ║\n"
+       << "║ Depth x Count       : " << setw(38) << (depths.empty() ? "-" : depths.substr(0, 38)) << " ║\n"
+       << "║ Orphans (dropped)   : " << setw(38) << (to_string(stats.orphansReceived) + " (" + to_string(stats.orphansDropped) + ")") << " ║\n"
+       << "║ Stale Rejected      : " << setw(38) << stats.staleRejected << " ║\n"
+       << "║ Invalid Rejected    : " << setw(38) << stats.invalidRejected << " ║\n"
+       << "║ Pruned Side Blocks  : " << setw(38) << stats.prunedBlocks << " ║\n"
+       << "║ Live Tips           : " << setw(38) << blockTree.getTips().size() << " ║\n"
+       << "╚═══════════════════════════════════════════════════════════╝\n\n";
+}
+
+// Shared mining pool statistics
+void Computer::displayMiningPoolStats()
+{
+    MiningPoolStats stats = MiningPool::instance().getStats();
+
+    EV << "\n╔═══════════════════════════════════════════════════════════╗\n"
+       << "║                  SHARED MINING POOL STATISTICS            ║\n"
+       << "╠═══════════════════════════════════════════════════════════╣\n"
+       << "║ Worker Threads      : " << setw(38) << stats.workers << " ║\n"
+       << "║ Tasks Submitted     : " << setw(38) << stats.tasksSubmitted << " ║\n"
+       << "║ Tasks Executed      : " << setw(38) << stats.tasksExecuted << " ║\n"
+       << "║ Tasks Skipped       : " << setw(38) << stats.tasksSkipped << " ║\n"
+       << "║ Steals              : " << setw(38) << stats.steals << " ║\n"
+       << "║ Jobs Cancelled      : " << setw(38) << stats.jobsCancelled << " ║\n"
+       << "║ Queue Depth (peak)  : " << setw(38) << stats.peakQueueDepth << " ║\n"
+       << "║ Utilization         : " << setw(37) << (stats.utilization * 100) << "% ║\n"
+       << "╚═══════════════════════════════════════════════════════════╝\n\n";
+}
+
+// Shared key pool statistics
+void Computer::displayKeyPoolStats()
+{
+    KeyPoolStats stats = KeyPool::instance().getStats();
+    double perKeyMs = stats.generated > 0 ? stats.generationSeconds * 1000.0 / stats.generated : 0.0;
+
+    EV << "\n╔═══════════════════════════════════════════════════════════╗\n"
+       << "║                  SHARED KEY POOL STATISTICS               ║\n"
+       << "╠═══════════════════════════════════════════════════════════╣\n"
+       << "║ Mode                : " << setw(38) << (stats.seeded ? "deterministic (seeded)" : "random") << " ║\n"
+       << "║ Available / Capacity: " << setw(38) << (to_string(stats.available) + " / " + to_string(stats.capacity)) << " ║\n"
+       << "║ Low-Water Mark      : " << setw(38) << stats.lowWaterMark << " ║\n"
+       << "║ Handed Out          : " << setw(38) << stats.handedOut << " ║\n"
+       << "║ Generated           : " << setw(38) << stats.generated << " ║\n"
+       << "║ Refill Runs         : " << setw(38) << stats.refills << " ║\n"
+       << "║ Empty-Pool Misses   : " << setw(38) << stats.misses << " ║\n"
+       << "║ Generation Time/Key : " << setw(35) << fixed << setprecision(3) << perKeyMs << " ms ║\n"
+       << "╚═══════════════════════════════════════════════════════════╝\n\n";
 }
\ No newline at end of file
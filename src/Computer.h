@@ -3,9 +3,13 @@
 
 #include <omnetpp.h>
 #include "Blockchain.h"
+#include "BlockTree.h"
 #include "FuzzyBFT.h"
 #include "ByzantineNode.h"
 #include "MiningEngine.h"
+#include "MiningPool.h"
+#include "KeyPool.h"
+#include "ValidatedBlock.h"
 #include <map>
 #include <set>
 
@@ -14,7 +18,8 @@ using namespace std;
 
 class Computer : public cSimpleModule {
 private:
-    Blockchain blockchain;
+    Blockchain blockchain;        // Active (heaviest) chain
+    BlockTree blockTree{blockchain};  // Competing branches; every block goes through it
     int nodeId;
     NodeType nodeType;
     cMessage *blockTimer;
@@ -34,6 +39,23 @@ private:
     int miningDifficulty;
     bool miningEnabled;
 
+    // Simulated-hashpower mining: discovery time is sampled instead of computed
+    bool simulatedMining;
+    double hashRate;
+    bool verifyWithRealHash;      // Simulated blocks carry a real nonce at SIMULATED_PROOF_BITS
+    static const int SIMULATED_PROOF_BITS = 8;   // ~256 header hashes per discovered block
+    cMessage *miningDoneTimer;
+    Block *pendingBlock;          // Block being "mined" until miningDoneTimer fires
+    simtime_t miningStartTime;
+
+    // Event-sliced real mining: a bounded nonce range per self-message
+    int miningSliceNonces;        // 0 mines the whole block inline
+    cMessage *miningSliceTimer;
+    MiningSession *activeMining;  // Resumable search in progress, if any
+
+    // Payload encryption for blocks this node creates
+    CipherFormat payloadFormat;   // FORMAT_HYBRID or FORMAT_BINARY
+
     // BFT statistics
     int blocksProposed;
     int blocksAccepted;
@@ -43,7 +65,7 @@ private:
     // Mining statistics
     int blocksMined;
     double totalMiningTime;
-    int totalMiningAttempts;
+    long long totalMiningAttempts;
 
 protected:
     virtual void initialize() override;
@@ -53,20 +75,32 @@ protected:
     // Mining-enabled block creation
     void createNewBlock();
     void mineAndBroadcastBlock(const std::string& blockData);
+    void publishMinedBlock(Block& block, long long attempts, double miningTimeMs);
+
+    // Simulated-hashpower mining
+    void startSimulatedMining(const Block& block);
+    void completeSimulatedMining();
+    void abortSimulatedMining(int height);
+
+    // Event-sliced real mining
+    void startSlicedMining(const Block& block);
+    void continueSlicedMining();
+    void abortSlicedMining(int height);
     
     void broadcastNewBlockSequentially(const std::string& blockData);
     void handleBlockProposal(cMessage *msg);
     void handleFuzzyVote(cMessage *msg);
-    void displayBlockData(const Block& block, const std::string& action);
-    void addBlockToChain(const Block& block);
+    // validated, when given, supplies the memoized digest instead of rehashing
+    void displayBlockData(const Block& block, const std::string& action, const ValidatedBlock *validated = nullptr);
+    void addBlockToChain(ValidatedBlock& block);  // Moves the block into the chain
 
     // Enhanced validation with mining verification
-    double calculateBlockValidity(const std::string& blockData);
+    double calculateBlockValidity(const ValidatedBlock& validated);
     
     // Fuzzy BFT decision making
     double calculateNodeReputation(int nodeId);
     double calculateNetworkConsensus(const std::string& blockId);
-    bool makeFuzzyBFTDecision(int proposerNode, const std::string& blockData, const std::string& blockId);
+    bool makeFuzzyBFTDecision(int proposerNode, const ValidatedBlock& block);
     void updateNodeReputation(int nodeId, bool positiveAction);
 
     // Byzantine behaviors
@@ -79,6 +113,9 @@ protected:
                          
     // Mining statistics display
     void displayMiningStats();
+    void displayForkStats();
+    void displayMiningPoolStats();
+    void displayKeyPoolStats();
 };
 
 #endif
\ No newline at end of file
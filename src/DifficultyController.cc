@@ -0,0 +1,135 @@
+#include "DifficultyController.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+DifficultyController::DifficultyController(int initialBits)
+    : algorithm(RETARGET_FIXED), targetBlockInterval(20.0), retargetInterval(10),
+      windowSize(30), maxAdjustment(4.0) {
+    setDifficultyBounds(1, 64);
+    setInitialDifficulty(initialBits);
+}
+
+void DifficultyController::setInitialDifficulty(int bits) {
+    initialTarget = Digest::targetFromBits(bits).toCompact();
+}
+
+void DifficultyController::setDifficultyBounds(int minBits, int maxBits) {
+    if (maxBits < minBits) swap(minBits, maxBits);
+    easiestTarget = targetToDouble(Digest::targetFromBits(minBits).toCompact());
+    hardestTarget = targetToDouble(Digest::targetFromBits(maxBits).toCompact());
+}
+
+uint32_t DifficultyController::expectedTarget(size_t height, const BlockAccessor& blockAt) const {
+    // Genesis and the block after it have no interval to measure
+    if (height < 2) {
+        return height == 0 ? initialTarget : blockAt(0).getDifficultyTarget();
+    }
+
+    switch (algorithm) {
+        case RETARGET_BITCOIN:
+            return retargetBitcoin(height, blockAt);
+        case RETARGET_LWMA:
+            return retargetLWMA(height, blockAt);
+        case RETARGET_FIXED:
+        default:
+            return initialTarget;
+    }
+}
+
+// Bitcoin: the target only moves on period boundaries, scaled by how long the
+// last period actually took compared with how long it should have taken
+uint32_t DifficultyController::retargetBitcoin(size_t height, const BlockAccessor& blockAt) const {
+    const Block& last = blockAt(height - 1);
+    if (height % retargetInterval != 0) {
+        return last.getDifficultyTarget();
+    }
+
+    size_t firstHeight = height > (size_t)retargetInterval ? height - retargetInterval : 1;
+    const Block& first = blockAt(firstHeight - 1);
+
+    double expected = targetBlockInterval * (double)(height - firstHeight);
+    double actual = last.getTimestamp() - first.getTimestamp();
+    actual = max(expected / maxAdjustment, min(expected * maxAdjustment, actual));
+
+    return clampTarget(targetToDouble(last.getDifficultyTarget()) * actual / expected);
+}
+
+// LWMA (zawy12): recent solve times carry linearly more weight, so the rate
+// recovers within a few blocks after a hash-power step instead of a full period
+uint32_t DifficultyController::retargetLWMA(size_t height, const BlockAccessor& blockAt) const {
+    size_t window = min((size_t)windowSize, height - 1);
+    size_t start = height - window;
+
+    double weightedSolveTime = 0.0;
+    double targetSum = 0.0;
+    double previousTimestamp = blockAt(start - 1).getTimestamp();
+    for (size_t i = 0; i < window; i++) {
+        const Block& block = blockAt(start + i);
+        double solveTime = block.getTimestamp() - previousTimestamp;
+        solveTime = max(-6.0 * targetBlockInterval, min(6.0 * targetBlockInterval, solveTime));
+        previousTimestamp = block.getTimestamp();
+
+        weightedSolveTime += solveTime * (double)(i + 1);
+        targetSum += targetToDouble(block.getDifficultyTarget());
+    }
+
+    double weightSum = (double)window * (double)(window + 1) / 2.0;
+    double minimumWeighted = weightSum * targetBlockInterval / maxAdjustment;
+    weightedSolveTime = max(minimumWeighted, weightedSolveTime);
+
+    double averageTarget = targetSum / (double)window;
+    return clampTarget(averageTarget * weightedSolveTime / (weightSum * targetBlockInterval));
+}
+
+uint32_t DifficultyController::clampTarget(double value) const {
+    return doubleToTarget(max(hardestTarget, min(easiestTarget, value)));
+}
+
+RetargetAlgorithm DifficultyController::parseAlgorithm(const string& name) {
+    if (name == "fixed") return RETARGET_FIXED;
+    if (name == "bitcoin") return RETARGET_BITCOIN;
+    if (name == "lwma") return RETARGET_LWMA;
+    throw invalid_argument("Unknown retarget algorithm: " + name);
+}
+
+const char* DifficultyController::algorithmName(RetargetAlgorithm algo) {
+    switch (algo) {
+        case RETARGET_BITCOIN: return "bitcoin";
+        case RETARGET_LWMA: return "lwma";
+        case RETARGET_FIXED:
+        default: return "fixed";
+    }
+}
+
+double DifficultyController::targetToDouble(uint32_t compact) {
+    int size = (int)(compact >> 24);
+    double mantissa = (double)(compact & 0x007fffff);
+    return ldexp(mantissa, 8 * (size - 3));
+}
+
+uint32_t DifficultyController::doubleToTarget(double value) {
+    if (!(value >= 1.0)) return 0x01010000;  // Smallest representable non-zero target
+
+    // value = fraction * 2^exponent with fraction in [0.5, 1)
+    int exponent = 0;
+    double fraction = frexp(value, &exponent);
+
+    int size = (exponent + 7) / 8;
+    uint32_t mantissa = (uint32_t)ldexp(fraction, exponent - 8 * (size - 3));
+    if (mantissa & 0x00800000) {
+        mantissa >>= 8;
+        size++;
+    }
+    if (size > 32) {
+        return Digest::targetFromBits(0).toCompact();
+    }
+    return ((uint32_t)size << 24) | mantissa;
+}
+
+double DifficultyController::difficultyBits(uint32_t compact) {
+    double target = targetToDouble(compact);
+    return target > 0.0 ? 256.0 - log2(target + 1.0) : 256.0;
+}
@@ -0,0 +1,68 @@
+#ifndef DIFFICULTYCONTROLLER_H
+#define DIFFICULTYCONTROLLER_H
+
+#include "Block.h"
+#include "HashUtils.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+
+using namespace std;
+
+enum RetargetAlgorithm {
+    RETARGET_FIXED = 0,     // Every block keeps the initial target
+    RETARGET_BITCOIN = 1,   // Rescale once every N blocks by (actual / expected) window timespan
+    RETARGET_LWMA = 2       // Linearly weighted moving average of recent solve times, every block
+};
+
+// Chooses the proof-of-work target each block height must carry. Targets are
+// kept in Bitcoin's compact form so every node derives bit-identical values
+// from the same chain, and validators can compare headers exactly.
+class DifficultyController {
+public:
+    typedef function<const Block&(size_t)> BlockAccessor;
+
+    DifficultyController(int initialBits = HashUtils::DEFAULT_DIFFICULTY_BITS);
+
+    // Compact target required of the block at `height`; blockAt must serve heights [0, height)
+    uint32_t expectedTarget(size_t height, const BlockAccessor& blockAt) const;
+
+    // Configuration
+    void setAlgorithm(RetargetAlgorithm algo) { algorithm = algo; }
+    void setInitialDifficulty(int bits);
+    void setTargetBlockInterval(double seconds) { targetBlockInterval = seconds > 0 ? seconds : 1.0; }
+    void setRetargetInterval(int blocks) { retargetInterval = blocks < 1 ? 1 : blocks; }
+    void setWindowSize(int blocks) { windowSize = blocks < 2 ? 2 : blocks; }
+    void setMaxAdjustment(double factor) { maxAdjustment = factor < 1.0 ? 1.0 : factor; }
+    void setDifficultyBounds(int minBits, int maxBits);
+
+    RetargetAlgorithm getAlgorithm() const { return algorithm; }
+    uint32_t getInitialTarget() const { return initialTarget; }
+    double getTargetBlockInterval() const { return targetBlockInterval; }
+
+    static RetargetAlgorithm parseAlgorithm(const string& name);  // Throws invalid_argument
+    static const char* algorithmName(RetargetAlgorithm algo);
+
+    // Compact target <-> approximate integer value (24-bit mantissa fits a double exactly)
+    static double targetToDouble(uint32_t compact);
+    static uint32_t doubleToTarget(double value);
+
+    // Difficulty as log2 of the expected hashes per block (= leading zero bits for bit targets)
+    static double difficultyBits(uint32_t compact);
+
+private:
+    RetargetAlgorithm algorithm;
+    uint32_t initialTarget;
+    double targetBlockInterval;  // Seconds of simulation time between blocks
+    int retargetInterval;        // RETARGET_BITCOIN: blocks per adjustment period
+    int windowSize;              // RETARGET_LWMA: solve times averaged
+    double maxAdjustment;        // Largest factor a single retarget may move the target
+    double easiestTarget;        // Lower difficulty bound
+    double hardestTarget;        // Upper difficulty bound
+
+    uint32_t retargetBitcoin(size_t height, const BlockAccessor& blockAt) const;
+    uint32_t retargetLWMA(size_t height, const BlockAccessor& blockAt) const;
+    uint32_t clampTarget(double value) const;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "Digest.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+inline uint64_t loadBE64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+Digest Digest::zero() {
+    Digest digest;
+    memset(digest.bytes, 0, SIZE);
+    return digest;
+}
+
+Digest Digest::fromBytes(const uint8_t* data) {
+    Digest digest;
+    memcpy(digest.bytes, data, SIZE);
+    return digest;
+}
+
+Digest Digest::fromHex(const string& hex) {
+    if (hex.length() != 2 * SIZE) {
+        throw invalid_argument("Digest hex must be 64 characters");
+    }
+    Digest digest;
+    for (size_t i = 0; i < SIZE; i++) {
+        int high = hexValue(hex[2 * i]);
+        int low = hexValue(hex[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            throw invalid_argument("Invalid hex character in digest");
+        }
+        digest.bytes[i] = (uint8_t)((high << 4) | low);
+    }
+    return digest;
+}
+
+string Digest::toHex() const {
+    static const char digits[] = "0123456789abcdef";
+    string hex(2 * SIZE, '0');
+    for (size_t i = 0; i < SIZE; i++) {
+        hex[2 * i] = digits[bytes[i] >> 4];
+        hex[2 * i + 1] = digits[bytes[i] & 0x0f];
+    }
+    return hex;
+}
+
+int Digest::leadingZeroBits() const {
+    for (int word = 0; word < 4; word++) {
+        uint64_t v = loadBE64(bytes + 8 * word);
+        if (v != 0) {
+            return word * 64 + __builtin_clzll(v);
+        }
+    }
+    return 256;
+}
+
+bool Digest::meetsTarget(const Digest& target) const {
+    return compare(target) <= 0;
+}
+
+Digest Digest::targetFromBits(int bits) {
+    if (bits < 0) bits = 0;
+    if (bits > 256) bits = 256;
+
+    Digest target;
+    memset(target.bytes, 0xff, SIZE);
+    int fullBytes = bits / 8;
+    memset(target.bytes, 0, fullBytes);
+    if (fullBytes < (int)SIZE) {
+        target.bytes[fullBytes] = (uint8_t)(0xff >> (bits % 8));
+    }
+    return target;
+}
+
+Digest Digest::fromCompact(uint32_t compact) {
+    int size = (int)(compact >> 24);
+    uint32_t mantissa = compact & 0x007fffff;
+
+    // value = mantissa * 256^(size - 3); mantissa bytes land at big-endian offset SIZE - size
+    Digest target = zero();
+    for (int i = 0; i < 3; i++) {
+        uint8_t byte = (uint8_t)(mantissa >> (8 * (2 - i)));
+        int pos = (int)SIZE - size + i;
+        if (pos < 0) {
+            if (byte != 0) {
+                memset(target.bytes, 0xff, SIZE);  // Overflow: saturate to the easiest target
+                return target;
+            }
+            continue;
+        }
+        if (pos < (int)SIZE) {
+            target.bytes[pos] = byte;
+        }
+    }
+    return target;
+}
+
+uint32_t Digest::toCompact() const {
+    size_t first = 0;
+    while (first < SIZE && bytes[first] == 0) first++;
+    if (first == SIZE) return 0;
+
+    uint32_t size = (uint32_t)(SIZE - first);
+    uint32_t mantissa = 0;
+    for (size_t i = 0; i < 3; i++) {
+        mantissa <<= 8;
+        if (first + i < SIZE) mantissa |= bytes[first + i];
+    }
+
+    // Keep the 0x00800000 bit clear, as Bitcoin reserves it for the sign
+    if (mantissa & 0x00800000) {
+        mantissa >>= 8;
+        size++;
+    }
+    return (size << 24) | mantissa;
+}
+
+int Digest::compare(const Digest& other) const {
+    // Word-wise big-endian compare: four 64-bit compares instead of 32 byte compares
+    for (int word = 0; word < 4; word++) {
+        uint64_t a = loadBE64(bytes + 8 * word);
+        uint64_t b = loadBE64(other.bytes + 8 * word);
+        if (a != b) return a < b ? -1 : 1;
+    }
+    return 0;
+}
@@ -0,0 +1,44 @@
+#ifndef DIGEST_H
+#define DIGEST_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+// Fixed-size 256-bit hash value (big-endian byte order, as SHA-256 emits it).
+// Trivially copyable; converted to hex only for logging and text formats.
+struct Digest {
+    static const size_t SIZE = 32;
+
+    uint8_t bytes[SIZE];
+
+    static Digest zero();
+    static Digest fromBytes(const uint8_t* data);
+    static Digest fromHex(const std::string& hex);  // Throws invalid_argument
+
+    std::string toHex() const;
+
+    // Number of leading zero bits (256 for the all-zero digest)
+    int leadingZeroBits() const;
+
+    // Proof-of-work comparison: digest <= target as 256-bit big-endian integers
+    bool meetsTarget(const Digest& target) const;
+
+    // Target with `bits` leading zero bits followed by all ones
+    static Digest targetFromBits(int bits);
+
+    // Bitcoin-style compact target encoding (8-bit byte length + 23-bit mantissa)
+    static Digest fromCompact(uint32_t compact);
+    uint32_t toCompact() const;
+
+    int compare(const Digest& other) const;
+    bool operator==(const Digest& other) const { return compare(other) == 0; }
+    bool operator!=(const Digest& other) const { return compare(other) != 0; }
+    bool operator<(const Digest& other) const { return compare(other) < 0; }
+};
+
+static_assert(sizeof(Digest) == Digest::SIZE, "Digest must be exactly 32 bytes");
+static_assert(std::is_trivially_copyable<Digest>::value, "Digest must be trivially copyable");
+
+#endif
@@ -1,7 +1,12 @@
 #include "ElGamal.h"
+#include "BigElGamal.h"
 #include "PrimeGenerator.h"
+#include "ChaCha20.h"
+#include "MontgomeryLanes.h"
+#include "SHA256.h"
 #include <sstream>
 #include <iostream>
+#include <stdexcept>
 
 using namespace std; 
 
@@ -34,6 +39,31 @@ long long ElGamal::mod_inverse(long long a, long long m) {
     return x1;
 }
 
+MontgomeryContext ElGamal::contextFor(long long p, const MontgomeryContext& cached) {
+    if (cached.isValid() && cached.getModulus() == (uint64_t)p) {
+        return cached;
+    }
+    return MontgomeryContext((uint64_t)p);
+}
+
+EncryptionStream::EncryptionStream(const PublicKey& publicKey, long long r)
+    : ctx(ElGamal::contextFor(publicKey.p, publicKey.mont)) {
+    e1Step = ctx.toMontgomery((uint64_t)publicKey.e1);
+    e2Step = ctx.toMontgomery((uint64_t)publicKey.e2);
+    c1Power = ctx.pow(e1Step, (uint64_t)r);
+    sharedPower = ctx.pow(e2Step, (uint64_t)r);
+}
+
+pair<long long, long long> EncryptionStream::next(long long m) {
+    long long c1 = (long long)ctx.fromMontgomery(c1Power);
+    // REDC(m * sR) = m*s mod p: the plaintext never needs converting (m * sR < 2^64 * p)
+    long long c2 = (long long)ctx.reduce((unsigned __int128)(uint64_t)m * sharedPower);
+
+    c1Power = ctx.multiply(c1Power, e1Step);
+    sharedPower = ctx.multiply(sharedPower, e2Step);
+    return {c1, c2};
+}
+
 KeyPair ElGamal::generateKeyPair() {
     long long p = PrimeGenerator::getRandomPrime();
     long long e1 = 2; // Simple generator
@@ -47,7 +77,8 @@ KeyPair ElGamal::generateKeyPair(long long p, long long e1, long long d) {
     key.p = p;
     key.e1 = e1;
     key.d = d;
-    key.e2 = mod_exp(e1, d, p);
+    key.mont = MontgomeryContext((uint64_t)p);
+    key.e2 = (long long)key.mont.powMod((uint64_t)e1, (uint64_t)d);
     return key;
 }
 
@@ -57,42 +88,242 @@ PublicKey ElGamal::extractPublicKey(const KeyPair& keyPair) {
     pubKey.e1 = keyPair.e1;
     pubKey.e2 = keyPair.e2;
     pubKey.p = keyPair.p;
+    pubKey.mont = keyPair.mont;
     return pubKey;
 }
 
 // Use PublicKey for encryption (no private key needed)
 pair<long long, long long> ElGamal::encrypt_char(long long m, long long r, const PublicKey& publicKey) {
-    long long c1 = mod_exp(publicKey.e1, r, publicKey.p);
-    long long c2 = (m * mod_exp(publicKey.e2, r, publicKey.p)) % publicKey.p;
+    MontgomeryContext ctx = contextFor(publicKey.p, publicKey.mont);
+    long long c1 = (long long)ctx.powMod((uint64_t)publicKey.e1, (uint64_t)r);
+    uint64_t shared = ctx.pow(ctx.toMontgomery((uint64_t)publicKey.e2), (uint64_t)r);
+    long long c2 = (long long)ctx.reduce((unsigned __int128)(uint64_t)m * shared);
     return {c1, c2};
 }
 
 // Decryption still uses private key (only locally)
 long long ElGamal::decrypt_char(const std::pair<long long, long long>& ciphertext, const KeyPair& keyPair) {
-    long long c1 = ciphertext.first;
-    long long c2 = ciphertext.second;
-    long long c1d = mod_exp(c1, keyPair.d, keyPair.p);
+    return decryptWith(contextFor(keyPair.p, keyPair.mont), ciphertext, keyPair);
+}
+
+long long ElGamal::decryptWith(const MontgomeryContext& ctx, const pair<long long, long long>& ciphertext,
+                               const KeyPair& keyPair) {
+    long long c1d = (long long)ctx.powMod((uint64_t)ciphertext.first, (uint64_t)keyPair.d);
     long long inv = mod_inverse(c1d, keyPair.p);
-    return (c2 * inv) % keyPair.p;
+    return (long long)ctx.mulMod((uint64_t)ciphertext.second, (uint64_t)inv);
+}
+
+namespace {
+
+const char PACKED_MARKER[] = "v2:";
+const size_t PACKED_MARKER_LENGTH = 3;
+
+const size_t BINARY_HEADER_SIZE = 3;
+const size_t HYBRID_HEADER_SIZE = 2;   // Format byte, limb width
+
+void appendLimb(string& out, unsigned long long value, size_t width) {
+    for (size_t i = 0; i < width; i++) {
+        out.push_back((char)(value & 0xff));
+        value >>= 8;
+    }
+}
+
+unsigned long long loadLimb(const unsigned char* data, size_t width) {
+    unsigned long long value = 0;
+    for (size_t i = width; i-- > 0;) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+void appendVarint(string& out, unsigned long long value) {
+    while (value >= 0x80) {
+        out.push_back((char)((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+} // namespace
+
+CiphertextView CiphertextView::parse(const char* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    if (size < BINARY_HEADER_SIZE + 1 || bytes[0] != FORMAT_BINARY) {
+        throw invalid_argument("Not a binary ciphertext");
+    }
+
+    CiphertextView view;
+    view.limbWidth = bytes[1];
+    view.elementWidth = bytes[2];
+    if (view.limbWidth == 0 || view.limbWidth > 8 || view.elementWidth == 0 || view.elementWidth > view.limbWidth) {
+        throw invalid_argument("Binary ciphertext has an invalid limb or element width");
+    }
+
+    size_t pos = BINARY_HEADER_SIZE;
+    unsigned long long length = 0;
+    for (int shift = 0; ; shift += 7) {
+        if (pos >= size || shift > 56) {
+            throw invalid_argument("Binary ciphertext has a truncated length field");
+        }
+        unsigned char byte = bytes[pos++];
+        length |= (unsigned long long)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) break;
+    }
+
+    // Bounded by the bytes present before any multiplication, so a huge length
+    // field cannot wrap the size check around to a match
+    size_t pairBytes = 2 * view.limbWidth;
+    size_t remaining = size - pos;
+    unsigned long long pairCount = length / view.elementWidth + (length % view.elementWidth != 0);
+    if (remaining % pairBytes != 0 || pairCount != remaining / pairBytes) {
+        throw invalid_argument("Binary ciphertext size does not match its length field");
+    }
+    view.plaintextLength = (size_t)length;
+    view.pairCount = (size_t)pairCount;
+    view.pairData = bytes + pos;
+    return view;
+}
+
+long long CiphertextView::readLimb(const unsigned char* limb) const {
+    return (long long)loadLimb(limb, limbWidth);
+}
+
+size_t ElGamal::limbWidth(long long p) {
+    size_t width = 1;
+    while (width < 8 && (unsigned long long)(p - 1) >> (8 * width) != 0) {
+        width++;
+    }
+    return width;
+}
+
+int ElGamal::bytesPerElement(long long p) {
+    int bytes = 0;
+    unsigned long long capacity = 256;  // 256^(bytes + 1)
+    while (bytes < 7 && capacity < (unsigned long long)p) {
+        bytes++;
+        capacity <<= 8;
+    }
+    return bytes;
 }
 
 // UPDATED: Encryption uses PublicKey only
-string ElGamal::encrypt_message(const string& message, long long r, const PublicKey& publicKey) {
+string ElGamal::encrypt_message(const string& message, long long r, const PublicKey& publicKey,
+                                CipherFormat format) {
+    EncryptionStream stream(publicKey, r);
     ostringstream oss;
-    for (size_t i = 0; i < message.length(); i++) {
-        long long m = (unsigned char)message[i];
-        auto cipher = encrypt_char(m, r + i, publicKey); // Use different r for each char
+
+    if (format == FORMAT_BYTEWISE) {
+        for (size_t i = 0; i < message.length(); i++) {
+            long long m = (unsigned char)message[i];
+            auto cipher = stream.next(m); // Use different r for each char (r + i)
+            oss << cipher.first << "," << cipher.second;
+            if (i < message.length() - 1) oss << ";";
+        }
+        return oss.str();
+    }
+
+    if (format == FORMAT_HYBRID) {
+        // Only the capsule uses the public key; the stream's first step is (e1^r, e2^r)
+        size_t limb = limbWidth(publicKey.p);
+        auto capsule = stream.next(1);
+
+        unsigned char key[ChaCha20::KEY_SIZE];
+        deriveSessionKey(capsule.first, capsule.second, publicKey.p, key);
+
+        string out;
+        out.reserve(HYBRID_HEADER_SIZE + limb + message.length());
+        out.push_back((char)FORMAT_HYBRID);
+        out.push_back((char)limb);
+        appendLimb(out, (unsigned long long)capsule.first, limb);
+        size_t bodyStart = out.size();
+        out.resize(bodyStart + message.length());
+
+        // The key is fresh for every r, so a fixed nonce is safe
+        const unsigned char nonce[ChaCha20::NONCE_SIZE] = {0};
+        ChaCha20::apply(key, nonce, 0, (const unsigned char*)message.data(),
+                        (unsigned char*)&out[bodyStart], message.length());
+        return out;
+    }
+
+    if (format == FORMAT_BINARY) {
+        size_t width = bytesPerElement(publicKey.p);
+        size_t limb = limbWidth(publicKey.p);
+        if (width == 0) {
+            throw invalid_argument("ElGamal modulus too small for packed plaintext");
+        }
+
+        size_t pairs = (message.length() + width - 1) / width;
+        string out;
+        out.reserve(BINARY_HEADER_SIZE + 10 + 2 * limb * pairs);
+        out.push_back((char)FORMAT_BINARY);
+        out.push_back((char)limb);
+        out.push_back((char)width);
+        appendVarint(out, message.length());
+
+        for (size_t offset = 0; offset < message.length(); offset += width) {
+            long long m = 0;
+            for (size_t j = 0; j < width; j++) {
+                unsigned char byte = offset + j < message.length() ? (unsigned char)message[offset + j] : 0;
+                m = (m << 8) | byte;
+            }
+            auto cipher = stream.next(m);
+            appendLimb(out, (unsigned long long)cipher.first, limb);
+            appendLimb(out, (unsigned long long)cipher.second, limb);
+        }
+        return out;
+    }
+
+    // Packed: big-endian groups of bytesPerElement bytes, the last one zero-padded;
+    // the length prefix lets decrypt_message drop the padding
+    size_t width = bytesPerElement(publicKey.p);
+    if (width == 0) {
+        throw invalid_argument("ElGamal modulus too small for packed plaintext");
+    }
+
+    oss << PACKED_MARKER << message.length() << ":";
+    for (size_t offset = 0; offset < message.length(); offset += width) {
+        long long m = 0;
+        for (size_t j = 0; j < width; j++) {
+            unsigned char byte = offset + j < message.length() ? (unsigned char)message[offset + j] : 0;
+            m = (m << 8) | byte;
+        }
+        auto cipher = stream.next(m); // Use different r for each element (r + i)
+        if (offset > 0) oss << ";";
         oss << cipher.first << "," << cipher.second;
-        if (i < message.length() - 1) oss << ";";
     }
     return oss.str();
 }
 
 // Decryption uses full KeyPair (private key)
 string ElGamal::decrypt_message(const string& ciphertext, const KeyPair& keyPair) {
-    stringstream ss(ciphertext);
+    if (CiphertextView::isBinary(ciphertext)) {
+        return decrypt_message(CiphertextView::parse(ciphertext), keyPair);
+    }
+    if (isHybrid(ciphertext)) {
+        return decryptHybrid(ciphertext, keyPair);
+    }
+    if (!ciphertext.empty() && ciphertext[0] == (char)FORMAT_HYBRID_WIDE) {
+        throw invalid_argument("Multi-limb ciphertext needs a key of its size");
+    }
+
+    // Version marker: packed elements with an explicit plaintext length
+    bool packed = ciphertext.compare(0, PACKED_MARKER_LENGTH, PACKED_MARKER) == 0;
+    size_t length = 0;
+    size_t width = 1;
+    size_t bodyStart = 0;
+    if (packed) {
+        size_t lengthEnd = ciphertext.find(':', PACKED_MARKER_LENGTH);
+        if (lengthEnd == string::npos) {
+            throw invalid_argument("Packed ciphertext is missing its length field");
+        }
+        length = stoull(ciphertext.substr(PACKED_MARKER_LENGTH, lengthEnd - PACKED_MARKER_LENGTH));
+        width = bytesPerElement(keyPair.p);
+        bodyStart = lengthEnd + 1;
+    }
+
+    stringstream ss(ciphertext.substr(bodyStart));
     string block;
-    string result;
+    vector<CipherBlock> pairs;
 
     while (getline(ss, block, ';')) {
         if (block.empty()) continue;
@@ -101,12 +332,147 @@ string ElGamal::decrypt_message(const string& ciphertext, const KeyPair& keyPair
 
         long long c1 = stoll(block.substr(0, pos));
         long long c2 = stoll(block.substr(pos + 1));
-        long long m = decrypt_char({c1, c2}, keyPair);
-        result.push_back((char)m);
+        pairs.push_back({c1, c2});
+    }
+
+    vector<long long> elements(pairs.size());
+    decrypt_message(pairs.data(), pairs.size(), keyPair, elements.data());
+
+    string result;
+    result.reserve(pairs.size() * width);
+    for (long long m : elements) {
+        for (size_t j = width; j-- > 0;) {
+            result.push_back((char)((m >> (8 * j)) & 0xff));
+        }
+    }
+
+    if (packed) {
+        if (result.size() < length) {
+            throw invalid_argument("Packed ciphertext is shorter than its declared length");
+        }
+        result.resize(length);
+    }
+    return result;
+}
+
+void ElGamal::deriveSessionKey(long long c1, long long secret, long long p, unsigned char key[32]) {
+    static const char label[] = "ElGamal-KEM/ChaCha20";
+    size_t limb = limbWidth(p);
+    string input(label, sizeof(label) - 1);
+    appendLimb(input, (unsigned long long)c1, limb);
+    appendLimb(input, (unsigned long long)secret, limb);
+    appendLimb(input, (unsigned long long)p, limb);
+    SHA256::hash((const uint8_t*)input.data(), input.size(), key);
+}
+
+long long ElGamal::hybridCapsule(const string& ciphertext) {
+    const unsigned char* bytes = (const unsigned char*)ciphertext.data();
+    if (ciphertext.size() < HYBRID_HEADER_SIZE || bytes[0] != FORMAT_HYBRID) {
+        throw invalid_argument("Not a hybrid ciphertext");
+    }
+    size_t limb = bytes[1];
+    if (limb == 0 || limb > 8 || ciphertext.size() < HYBRID_HEADER_SIZE + limb) {
+        throw invalid_argument("Hybrid ciphertext has a truncated capsule");
+    }
+    return (long long)loadLimb(bytes + HYBRID_HEADER_SIZE, limb);
+}
+
+// Hybrid ciphertext: one exponentiation recovers the shared secret, the body is a keystream XOR
+string ElGamal::decryptHybrid(const string& ciphertext, const KeyPair& keyPair) {
+    long long c1 = hybridCapsule(ciphertext);
+    if (c1 <= 0 || c1 >= keyPair.p) {
+        throw invalid_argument("Hybrid capsule is outside the key's group");
     }
+
+    MontgomeryContext ctx = contextFor(keyPair.p, keyPair.mont);
+    long long secret = (long long)ctx.powMod((uint64_t)c1, (uint64_t)keyPair.d);
+
+    unsigned char key[ChaCha20::KEY_SIZE];
+    deriveSessionKey(c1, secret, keyPair.p, key);
+
+    size_t bodyStart = HYBRID_HEADER_SIZE + (unsigned char)ciphertext[1];
+    string result(ciphertext.size() - bodyStart, '\0');
+    const unsigned char nonce[ChaCha20::NONCE_SIZE] = {0};
+    ChaCha20::apply(key, nonce, 0, (const unsigned char*)ciphertext.data() + bodyStart,
+                    (unsigned char*)&result[0], result.size());
     return result;
 }
 
+// Binary ciphertext: pairs are decoded straight from the view's buffer
+string ElGamal::decrypt_message(const CiphertextView& ciphertext, const KeyPair& keyPair) {
+    size_t width = ciphertext.getElementWidth();
+
+    vector<CipherBlock> pairs(ciphertext.size());
+    for (size_t i = 0; i < pairs.size(); i++) {
+        pairs[i] = ciphertext[i];
+    }
+    vector<long long> elements(pairs.size());
+    decrypt_message(pairs.data(), pairs.size(), keyPair, elements.data());
+
+    string result;
+    result.reserve(pairs.size() * width);
+    for (long long m : elements) {
+        for (size_t j = width; j-- > 0;) {
+            result.push_back((char)((m >> (8 * j)) & 0xff));
+        }
+    }
+    result.resize(ciphertext.getPlaintextLength());
+    return result;
+}
+
+// Montgomery's simultaneous inversion: with prefix products P_i = x_0 * ... * x_i
+// of the shared secrets x_i = c1_i^d, a single inverse of P_(n-1) yields every
+// x_i^-1 walking backwards (x_i^-1 = P_(i-1) * P_i^-1, P_(i-1)^-1 = x_i * P_i^-1).
+// That is one extended-Euclid run plus 3(n-1) multiplies instead of n inversions.
+void ElGamal::decrypt_message(const CipherBlock* pairs, size_t count, const KeyPair& keyPair, long long* plaintext) {
+    if (count == 0) return;
+
+    MontgomeryContext ctx = contextFor(keyPair.p, keyPair.mont);
+    uint64_t p = ctx.getModulus();
+
+    // Shared secrets in Montgomery form, kept in the output buffer until the backward pass
+    uint64_t* secrets = (uint64_t*)plaintext;
+    for (size_t i = 0; i < count; i++) {
+        if ((uint64_t)pairs[i].c1 % p == 0) {
+            throw invalid_argument("Ciphertext c1 is not invertible modulo p");
+        }
+    }
+
+    // Every c1 is raised to the same d: long messages under a sub-2^32 modulus go through the lane kernel
+    if (count >= MontgomeryLanes::MIN_BATCH && MontgomeryLanes::supports(p) &&
+        MontgomeryLanes::getBackend() != MontgomeryLanes::BACKEND_SCALAR) {
+        for (size_t i = 0; i < count; i++) {
+            secrets[i] = (uint64_t)pairs[i].c1;
+        }
+        MontgomeryLanes::powMod(secrets, count, (uint64_t)keyPair.d, p, secrets);
+        for (size_t i = 0; i < count; i++) {
+            secrets[i] = ctx.toMontgomery(secrets[i]);
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            secrets[i] = ctx.pow(ctx.toMontgomery((uint64_t)pairs[i].c1), (uint64_t)keyPair.d);
+        }
+    }
+
+    vector<uint64_t> prefix(count);
+    uint64_t running = ctx.one();
+    for (size_t i = 0; i < count; i++) {
+        running = ctx.multiply(running, secrets[i]);
+        prefix[i] = running;
+    }
+
+    long long productInverse = mod_inverse((long long)ctx.fromMontgomery(running), keyPair.p);
+    uint64_t inverse = ctx.toMontgomery((uint64_t)productInverse);  // (P_i)^-1, starting at i = n-1
+
+    for (size_t i = count; i-- > 0;) {
+        uint64_t secretInverse = i > 0 ? ctx.multiply(inverse, prefix[i - 1]) : inverse;
+        if (i > 0) inverse = ctx.multiply(inverse, secrets[i]);
+
+        // REDC(c2 * x^-1 R) = c2 * x^-1 mod p
+        plaintext[i] = (long long)ctx.reduce((unsigned __int128)(uint64_t)pairs[i].c2 * secretInverse);
+    }
+}
+
 // SECURE serialization - public key only
 string ElGamal::publicKeyToString(const PublicKey& publicKey) {
     ostringstream oss;
@@ -129,6 +495,185 @@ PublicKey ElGamal::stringToPublicKey(const string& keyStr) {
     getline(ss, item, ':');
     publicKey.p = stoll(item);
 
+    // Prepare the reduction context once per received key; a bad modulus is
+    // only reported when the key is actually used
+    try {
+        publicKey.mont = MontgomeryContext((uint64_t)publicKey.p);
+    } catch (const invalid_argument&) {
+        publicKey.mont = MontgomeryContext();
+    }
+
+    return publicKey;
+}
+
+string ElGamal::publicKeyToBytes(const PublicKey& publicKey) {
+    size_t width = limbWidth(publicKey.p);
+    string out;
+    out.reserve(1 + 3 * width);
+    out.push_back((char)width);
+    appendLimb(out, (unsigned long long)publicKey.e1, width);
+    appendLimb(out, (unsigned long long)publicKey.e2, width);
+    appendLimb(out, (unsigned long long)publicKey.p, width);
+    return out;
+}
+
+PublicKey ElGamal::publicKeyFromBytes(const char* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t width = size > 0 ? bytes[0] : 0;
+    if (width == 0 || width > 8 || size != 1 + 3 * width) {
+        throw invalid_argument("Malformed binary public key");
+    }
+
+    PublicKey publicKey;
+    publicKey.e1 = (long long)loadLimb(bytes + 1, width);
+    publicKey.e2 = (long long)loadLimb(bytes + 1 + width, width);
+    publicKey.p = (long long)loadLimb(bytes + 1 + 2 * width, width);
+
+    try {
+        publicKey.mont = MontgomeryContext((uint64_t)publicKey.p);
+    } catch (const invalid_argument&) {
+        publicKey.mont = MontgomeryContext();
+    }
+    return publicKey;
+}
+
+namespace {
+
+const size_t WIDE_HYBRID_HEADER_SIZE = 3;
+
+// deriveSessionKey over BigInt values, each in its constant-size byte form
+template <size_t Limbs>
+void deriveWideSessionKey(const BigInt<Limbs>& c1, const BigInt<Limbs>& secret, const BigInt<Limbs>& p,
+                          unsigned char key[ChaCha20::KEY_SIZE]) {
+    static const char label[] = "ElGamal-KEM/ChaCha20";
+    string input(label, sizeof(label) - 1);
+    uint8_t bytes[BigInt<Limbs>::BYTES];
+    for (const BigInt<Limbs>* value : {&c1, &secret, &p}) {
+        value->toBytes(bytes);
+        input.append((const char*)bytes, sizeof(bytes));
+    }
+    SHA256::hash((const uint8_t*)input.data(), input.size(), key);
+}
+
+template <size_t Limbs>
+SizedKeyPair generateWideKeyPair(mt19937_64& rng) {
+    typedef BigElGamal<Limbs> Scheme;
+    typename Scheme::KeyPairType keyPair = Scheme::generateKeyPair(rng);
+
+    SizedKeyPair sized;
+    sized.bits = (int)Scheme::Int::BITS;
+    sized.wide.resize(Scheme::Int::BYTES);
+    keyPair.d.toBytes((uint8_t*)&sized.wide[0]);
+    sized.wide += Scheme::publicKeyToBytes(Scheme::extractPublicKey(keyPair));
+    return sized;
+}
+
+template <size_t Limbs>
+string encryptWide(const string& message, const string& publicKeyBytes, mt19937_64& rng) {
+    typedef BigElGamal<Limbs> Scheme;
+    typedef typename Scheme::Int Int;
+    typename Scheme::PublicKeyType publicKey = Scheme::publicKeyFromBytes(publicKeyBytes.data(),
+                                                                          publicKeyBytes.size());
+    Int r = Scheme::randomExponent(publicKey.p, rng);
+    Int c1 = publicKey.mont.powMod(publicKey.e1, r);
+    unsigned char key[ChaCha20::KEY_SIZE];
+    deriveWideSessionKey(c1, publicKey.mont.powMod(publicKey.e2, r), publicKey.p, key);
+
+    size_t bodyStart = WIDE_HYBRID_HEADER_SIZE + Int::BYTES;
+    string out(bodyStart + message.length(), '\0');
+    out[0] = (char)FORMAT_HYBRID_WIDE;
+    out[1] = (char)(Int::BYTES & 0xff);
+    out[2] = (char)(Int::BYTES >> 8);
+    c1.toBytes((uint8_t*)&out[WIDE_HYBRID_HEADER_SIZE]);
+
+    // The key is fresh for every r, so a fixed nonce is safe
+    const unsigned char nonce[ChaCha20::NONCE_SIZE] = {0};
+    ChaCha20::apply(key, nonce, 0, (const unsigned char*)message.data(), (unsigned char*)&out[bodyStart],
+                    message.length());
+    return out;
+}
+
+template <size_t Limbs>
+string decryptWide(const string& ciphertext, const string& privateKeyBytes) {
+    typedef BigElGamal<Limbs> Scheme;
+    typedef typename Scheme::Int Int;
+    if (privateKeyBytes.size() != Int::BYTES + Scheme::PUBLIC_KEY_BYTES) {
+        throw invalid_argument("Malformed multi-limb ElGamal private key");
+    }
+    typename Scheme::PublicKeyType publicKey = Scheme::publicKeyFromBytes(privateKeyBytes.data() + Int::BYTES,
+                                                                          Scheme::PUBLIC_KEY_BYTES);
+    Int d = Int::fromBytes((const uint8_t*)privateKeyBytes.data());
+
+    const unsigned char* bytes = (const unsigned char*)ciphertext.data();
+    size_t bodyStart = WIDE_HYBRID_HEADER_SIZE + Int::BYTES;
+    if (ciphertext.size() < bodyStart || bytes[0] != FORMAT_HYBRID_WIDE ||
+        (size_t)(bytes[1] | bytes[2] << 8) != Int::BYTES) {
+        throw invalid_argument("Multi-limb hybrid ciphertext does not match the key size");
+    }
+    Int c1 = Int::fromBytes(bytes + WIDE_HYBRID_HEADER_SIZE);
+    if (c1.isZero() || !(c1 < publicKey.p)) {
+        throw invalid_argument("Hybrid capsule is outside the key's group");
+    }
+
+    unsigned char key[ChaCha20::KEY_SIZE];
+    deriveWideSessionKey(c1, publicKey.mont.powMod(c1, d), publicKey.p, key);
+
+    string result(ciphertext.size() - bodyStart, '\0');
+    const unsigned char nonce[ChaCha20::NONCE_SIZE] = {0};
+    ChaCha20::apply(key, nonce, 0, bytes + bodyStart, (unsigned char*)&result[0], result.size());
+    return result;
+}
+
+invalid_argument unsupportedKeySize(int bits) {
+    return invalid_argument("No ElGamal backend for " + to_string(bits) + "-bit keys");
+}
+
+} // namespace
+
+SizedKeyPair ElGamal::generateKeyPair(int bits, mt19937_64& rng) {
+    switch (bits) {
+    case 0: {
+        SizedKeyPair key;
+        key.native = generateKeyPair();
+        return key;
+    }
+    case 1024: return generateWideKeyPair<16>(rng);
+    case 2048: return generateWideKeyPair<32>(rng);
+    case 3072: return generateWideKeyPair<48>(rng);
+    default: throw unsupportedKeySize(bits);
+    }
+}
+
+SizedPublicKey ElGamal::extractPublicKey(const SizedKeyPair& keyPair) {
+    SizedPublicKey publicKey;
+    publicKey.bits = keyPair.bits;
+    if (keyPair.bits == 0) {
+        publicKey.native = extractPublicKey(keyPair.native);
+    } else {
+        publicKey.wide = keyPair.wide.substr(min(keyPair.wide.size(), (size_t)keyPair.bits / 8));   // Past d
+    }
     return publicKey;
 }
 
+string ElGamal::encrypt_message(const string& message, const SizedPublicKey& publicKey, mt19937_64& rng) {
+    switch (publicKey.bits) {
+    case 0: {
+        uniform_int_distribution<long long> exponent(2, publicKey.native.p - 2);
+        return encrypt_message(message, exponent(rng), publicKey.native, FORMAT_HYBRID);
+    }
+    case 1024: return encryptWide<16>(message, publicKey.wide, rng);
+    case 2048: return encryptWide<32>(message, publicKey.wide, rng);
+    case 3072: return encryptWide<48>(message, publicKey.wide, rng);
+    default: throw unsupportedKeySize(publicKey.bits);
+    }
+}
+
+string ElGamal::decrypt_message(const string& ciphertext, const SizedKeyPair& keyPair) {
+    switch (keyPair.bits) {
+    case 0: return decrypt_message(ciphertext, keyPair.native);
+    case 1024: return decryptWide<16>(ciphertext, keyPair.wide);
+    case 2048: return decryptWide<32>(ciphertext, keyPair.wide);
+    case 3072: return decryptWide<48>(ciphertext, keyPair.wide);
+    default: throw unsupportedKeySize(keyPair.bits);
+    }
+}
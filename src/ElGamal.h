@@ -4,18 +4,22 @@
 #include <string>
 #include <vector>
 #include <utility>
+#include <random>
+#include "Montgomery.h"
 
 using namespace std;
 
 struct KeyPair {
-    long long d;       // private key
-    long long e1, e2;  // public key components
-    long long p;       // prime modulus
+    long long d = 0;          // private key
+    long long e1 = 0, e2 = 0; // public key components
+    long long p = 0;          // prime modulus
+    MontgomeryContext mont;   // Cached reduction context for p (never transmitted)
 };
 
 struct PublicKey {
-    long long e1, e2;  // public key components only
-    long long p;       // prime modulus
+    long long e1 = 0, e2 = 0; // public key components only
+    long long p = 0;          // prime modulus
+    MontgomeryContext mont;   // Cached reduction context for p (rebuilt on deserialization)
 };
 
 struct CipherBlock {
@@ -23,12 +27,116 @@ struct CipherBlock {
     long long c2;
 };
 
+// Key of either backend, chosen by size: bits == 0 holds a native KeyPair,
+// 1024/2048/3072 a BigElGamal<bits / 64> key as bytes (d, then its public key)
+struct SizedKeyPair {
+    int bits = 0;
+    KeyPair native;
+    string wide;
+};
+
+struct SizedPublicKey {
+    int bits = 0;
+    PublicKey native;
+    string wide;              // BigElGamal public key bytes (e1, e2, p)
+};
+
+// Ciphertext formats; decrypt_message accepts all of them
+enum CipherFormat {
+    FORMAT_BYTEWISE = 1,   // Text "c1,c2;c1,c2;..." with one plaintext byte per pair
+    FORMAT_PACKED = 2,     // Text "v2:<length>:c1,c2;..." with bytesPerElement(p) bytes per pair
+    FORMAT_BINARY = 3,     // Packed elements as fixed-width little-endian limbs (see CiphertextView)
+    FORMAT_HYBRID = 4,     // One ElGamal-KEM capsule, payload under ChaCha20 (see encrypt_message)
+    FORMAT_HYBRID_WIDE = 5 // FORMAT_HYBRID with a multi-limb capsule (see the key-size dispatch)
+};
+
+// Non-owning view over a FORMAT_BINARY ciphertext laid out as
+//   [0]      format byte (FORMAT_BINARY)
+//   [1]      limb width w: bytes per c1/c2 value, little-endian
+//   [2]      plaintext bytes packed into each element
+//   [3..]    plaintext length as an unsigned LEB128 varint
+//   [rest]   ceil(length / elementWidth) pairs, c1 then c2, 2w bytes per pair
+// parse() validates only the header and total size; pairs are decoded on access,
+// so iterating a ciphertext inside a received message never allocates.
+class CiphertextView {
+private:
+    const unsigned char* pairData;
+    size_t pairCount;
+    size_t limbWidth;
+    size_t elementWidth;
+    size_t plaintextLength;
+
+    long long readLimb(const unsigned char* limb) const;
+
+public:
+    class iterator {
+    private:
+        const CiphertextView* view;
+        size_t index;
+    public:
+        iterator(const CiphertextView* v, size_t i) : view(v), index(i) {}
+        CipherBlock operator*() const { return (*view)[index]; }
+        iterator& operator++() { index++; return *this; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+    };
+
+    CiphertextView() : pairData(nullptr), pairCount(0), limbWidth(0), elementWidth(0), plaintextLength(0) {}
+
+    // Throws invalid_argument for a truncated or inconsistent buffer; data must outlive the view
+    static CiphertextView parse(const char* data, size_t size);
+    static CiphertextView parse(const string& data) { return parse(data.data(), data.size()); }
+    static bool isBinary(const string& data) { return !data.empty() && data[0] == (char)FORMAT_BINARY; }
+
+    size_t size() const { return pairCount; }
+    size_t getElementWidth() const { return elementWidth; }
+    size_t getPlaintextLength() const { return plaintextLength; }
+
+    CipherBlock operator[](size_t index) const {
+        const unsigned char* pair = pairData + 2 * limbWidth * index;
+        return {readLimb(pair), readLimb(pair + limbWidth)};
+    }
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, pairCount); }
+};
+
+// Encrypts successive characters with ephemeral exponents r, r+1, r+2, ...
+// for one public key. The running powers e1^k and e2^k are kept in Montgomery
+// form and advanced by one multiply each, so a character costs two modular
+// multiplies and two reductions instead of two full exponentiations.
+class EncryptionStream {
+private:
+    MontgomeryContext ctx;
+    uint64_t e1Step, e2Step;   // e1, e2 in Montgomery form
+    uint64_t c1Power;          // e1^k in Montgomery form
+    uint64_t sharedPower;      // e2^k in Montgomery form
+
+public:
+    EncryptionStream(const PublicKey& publicKey, long long r);  // Throws invalid_argument for a bad modulus
+
+    // Ciphertext of m under the current exponent k, then k -> k + 1
+    pair<long long, long long> next(long long m);
+};
+
 class ElGamal {
 private:
+    // Cached context when it matches p, otherwise a fresh one (throws invalid_argument for a bad modulus)
+    static MontgomeryContext contextFor(long long p, const MontgomeryContext& cached);
+
+    friend class EncryptionStream;
+
+    static long long decryptWith(const MontgomeryContext& ctx, const pair<long long, long long>& ciphertext,
+                                 const KeyPair& keyPair);
+
+    // ChaCha20 key for a hybrid ciphertext: SHA-256 over the capsule c1, the shared secret and p
+    static void deriveSessionKey(long long c1, long long secret, long long p, unsigned char key[32]);
+    static string decryptHybrid(const string& ciphertext, const KeyPair& keyPair);
+
+public:
+    // Reference square-and-multiply using a 128-bit division per step; kept as
+    // the baseline the Montgomery path is benchmarked against
     static long long mod_exp(long long base, long long exp, long long mod);
     static long long mod_inverse(long long a, long long m);
 
-public:
     static KeyPair generateKeyPair();
     static KeyPair generateKeyPair(long long p, long long e1, long long d);
     
@@ -38,13 +146,53 @@ public:
     static pair<long long, long long> encrypt_char(long long m, long long r, const PublicKey& publicKey);
     static long long decrypt_char(const pair<long long, long long>& ciphertext, const KeyPair& keyPair);
 
-    static string encrypt_message(const string& message, long long r, const PublicKey& publicKey);
+    // FORMAT_HYBRID costs two exponentiations per message whatever its length:
+    //   [0]      format byte (FORMAT_HYBRID)
+    //   [1]      limb width w
+    //   [2..2+w) capsule c1 = e1^r, little-endian
+    //   [rest]   message XORed with ChaCha20 keyed by deriveSessionKey(c1, e2^r)
+    // r is the per-message session key; reusing it under the same public key reuses the keystream.
+    static string encrypt_message(const string& message, long long r, const PublicKey& publicKey,
+                                  CipherFormat format = FORMAT_BINARY);
     static string decrypt_message(const string& ciphertext, const KeyPair& keyPair);
+    static string decrypt_message(const CiphertextView& ciphertext, const KeyPair& keyPair);
+
+    // Batch decryption of count pairs into plaintext elements with a single modular
+    // inversion; throws invalid_argument if some c1 is 0 mod p
+    static void decrypt_message(const CipherBlock* pairs, size_t count, const KeyPair& keyPair, long long* plaintext);
+
+    // True if the ciphertext starts with the FORMAT_HYBRID tag
+    static bool isHybrid(const string& ciphertext) { return !ciphertext.empty() && ciphertext[0] == (char)FORMAT_HYBRID; }
+    // Capsule c1 of a FORMAT_HYBRID ciphertext; throws invalid_argument if malformed
+    static long long hybridCapsule(const string& ciphertext);
+
+    // Key-size dispatch: bits == 0 runs the native scheme above, 1024, 2048 and
+    // 3072 the multi-limb BigElGamal backend in the MODP group of that size.
+    // Messages are hybrid either way, so only the capsule scales with the key:
+    //   [0]      format byte (FORMAT_HYBRID_WIDE)
+    //   [1..3)   capsule width w = bits / 8, little-endian
+    //   [3..3+w) capsule c1 = e1^r, big-endian
+    //   [rest]   message XORed with ChaCha20 keyed by SHA-256 over c1, e2^r and p
+    // r is drawn from rng. Throws invalid_argument for other sizes or a
+    // ciphertext of another size than the key.
+    static SizedKeyPair generateKeyPair(int bits, mt19937_64& rng);
+    static SizedPublicKey extractPublicKey(const SizedKeyPair& keyPair);
+    static string encrypt_message(const string& message, const SizedPublicKey& publicKey, mt19937_64& rng);
+    static string decrypt_message(const string& ciphertext, const SizedKeyPair& keyPair);
+
+    // Plaintext bytes packed into one element: the largest k with 256^k < p
+    static int bytesPerElement(long long p);
 
     // SECURE serialization - only public key components
     static string publicKeyToString(const PublicKey& publicKey);
     static PublicKey stringToPublicKey(const string& keyStr);
-    
+
+    // Binary public key: limb width w, then e1, e2, p as w-byte little-endian values
+    static string publicKeyToBytes(const PublicKey& publicKey);
+    static PublicKey publicKeyFromBytes(const char* data, size_t size);  // Throws invalid_argument
+
+    // Bytes needed to hold any value below p
+    static size_t limbWidth(long long p);
 
 };
 
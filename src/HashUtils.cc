@@ -1,56 +1,53 @@
 #include "HashUtils.h"
-#include <sstream>
-#include <iomanip>
+#include "SHA256.h"
 #include <chrono>
 #include <cstring>
 
 using namespace std;
 
-string HashUtils::calculateSHA256(const string& input) {
-
-    hash<string> hasher1;
-    hash<string> hasher2;
-
-
-    size_t hash1 = hasher1(input);
-    size_t hash2 = hasher2(input + "salt");
-    
-
-        stringstream ss;
-    ss << hex << setfill('0') << setw(16) << hash1 << setw(16) << hash2;
+Digest HashUtils::calculateSHA256(const string& input) {
+    Digest digest;
+    SHA256::hash((const uint8_t*)input.data(), input.size(), digest.bytes);
+    return digest;
+}
 
-    // Pad to 64 characters to simulate SHA-256 output
-    string result = ss.str();
-    while (result.length() < 64) {
-        result = "0" + result;
-    }
-    
-    // Truncate to 64 characters if too long
-    if (result.length() > 64) {
-        result = result.substr(0, 64);
+vector<Digest> HashUtils::calculateSHA256Batch(const vector<string>& inputs) {
+    vector<const uint8_t*> data(inputs.size());
+    vector<size_t> lengths(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        data[i] = (const uint8_t*)inputs[i].data();
+        lengths[i] = inputs[i].size();
     }
-    
-    return result;
+
+    // Digest is exactly 32 bytes, so the array doubles as the kernel's output buffer
+    vector<Digest> digests(inputs.size());
+    SHA256::hashBatch(data.data(), lengths.data(), inputs.size(), (uint8_t*)digests.data());
+    return digests;
 }
 
-bool HashUtils::isHashValid(const string& hash, int difficulty) {
-    if (hash.length() < difficulty) return false;
-    
+bool HashUtils::isHashValid(const Digest& hash, int difficultyBits) {
+    return hash.leadingZeroBits() >= difficultyBits;
+}
 
-    for (int i = 0; i < difficulty; i++) {
-        if (hash[i] != '0') {
-            return false;
-        }
-    }
-    
-    return true;
+bool HashUtils::isHashValid(const Digest& hash, const Digest& target) {
+    return hash.meetsTarget(target);
 }
 
-string HashUtils::generateTarget(int difficulty) {
-    return string(difficulty, '0') + string(64 - difficulty, 'f');
+Digest HashUtils::generateTarget(int difficultyBits) {
+    return Digest::targetFromBits(difficultyBits);
 }
 
 double HashUtils::calculateHashRate(int attempts, double timeSeconds) {
     if (timeSeconds <= 0) return 0.0;
     return attempts / timeSeconds; 
+}
+
+string HashUtils::toHex(const unsigned char* bytes, size_t length) {
+    static const char digits[] = "0123456789abcdef";
+    string hex(length * 2, '0');
+    for (size_t i = 0; i < length; i++) {
+        hex[2 * i] = digits[bytes[i] >> 4];
+        hex[2 * i + 1] = digits[bytes[i] & 0x0f];
+    }
+    return hex;
 }
\ No newline at end of file
@@ -2,24 +2,34 @@
 #define HASHUTILS_H
 
 #include <string>
-#include <sstream>
-#include <iomanip>
-#include <functional>
+#include <vector>
+#include "Digest.h"
 
 class HashUtils {
 public:
-    // Simple SHA-256 simulation for educational purposes
-    // Note: This is NOT cryptographically secure - for simulation only
-    static std::string calculateSHA256(const std::string& input);
-    
-    // Validate hash against difficulty target
-    static bool isHashValid(const std::string& hash, int difficulty);
-    
-    // Generate target string for given difficulty
-    static std::string generateTarget(int difficulty);
-    
+    // Proof-of-work difficulty is counted in leading zero bits of the digest
+    static const int DEFAULT_DIFFICULTY_BITS = 16;
+
+    // SHA-256 (FIPS 180-4) of the input
+    static Digest calculateSHA256(const std::string& input);
+
+    // Hash several independent inputs at once using the SIMD multi-buffer kernels
+    static std::vector<Digest> calculateSHA256Batch(const std::vector<std::string>& inputs);
+
+    // Validate hash against difficulty (leading zero bits)
+    static bool isHashValid(const Digest& hash, int difficultyBits);
+
+    // Validate hash against an explicit 256-bit target
+    static bool isHashValid(const Digest& hash, const Digest& target);
+
+    // Generate target for given difficulty
+    static Digest generateTarget(int difficultyBits);
+
     // Hash rate calculation utilities
     static double calculateHashRate(int attempts, double timeSeconds);
+
+    // Lowercase hex encoding of raw bytes
+    static std::string toHex(const unsigned char* bytes, size_t length);
 };
 
-#endif
\ No newline at end of file
+#endif
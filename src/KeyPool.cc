@@ -0,0 +1,148 @@
+#include "KeyPool.h"
+#include "PrimeGenerator.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+const size_t DEFAULT_CAPACITY = 64;
+const size_t DEFAULT_LOW_WATER_MARK = 16;
+
+unsigned long long clockSeed() {
+    return (unsigned long long)chrono::steady_clock::now().time_since_epoch().count();
+}
+}
+
+KeyPool& KeyPool::instance() {
+    static KeyPool pool;
+    return pool;
+}
+
+KeyPool::KeyPool()
+    : rng(clockSeed()), seed(0), capacity(DEFAULT_CAPACITY), lowWaterMark(DEFAULT_LOW_WATER_MARK),
+      stopping(false), handedOut(0), generated(0), refills(0), misses(0), generationNanos(0) {
+    // The prime table is filled lazily; do it here rather than racing on the refill thread
+    PrimeGenerator::getPrimes();
+    refiller = thread(&KeyPool::refillLoop, this);
+}
+
+KeyPool::~KeyPool() {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    refillNeeded.notify_all();
+    refiller.join();
+}
+
+void KeyPool::configure(size_t newCapacity, size_t newLowWaterMark, unsigned long long newSeed) {
+    lock_guard<mutex> generatorLock(generatorMutex);
+    lock_guard<mutex> lock(queueMutex);
+
+    capacity = newCapacity;
+    lowWaterMark = min(newLowWaterMark, newCapacity);
+    if (newSeed != seed) {
+        seed = newSeed;
+        rng.seed(seed != 0 ? seed : clockSeed());
+        queue.clear();
+    }
+    while (queue.size() > capacity) {
+        queue.pop_back();   // Newest first, so the sequence stays in order
+    }
+    refillNeeded.notify_one();
+}
+
+KeyMaterial KeyPool::generate() {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    // Own generator rather than PrimeGenerator's: this runs on the refill thread
+    const vector<long long>& primes = PrimeGenerator::getPrimes();
+    long long p = primes[uniform_int_distribution<size_t>(0, primes.size() - 1)(rng)];
+    long long d = uniform_int_distribution<long long>(2, p - 2)(rng);
+
+    KeyMaterial material;
+    material.keyPair = ElGamal::generateKeyPair(p, 2, d);
+    material.sessionKey = uniform_int_distribution<long long>(100, p - 100)(rng);
+
+    generated++;
+    generationNanos += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    return material;
+}
+
+KeyMaterial KeyPool::acquire() {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        if (!queue.empty()) {
+            KeyMaterial material = queue.front();
+            queue.pop_front();
+            handedOut++;
+            if (queue.size() < lowWaterMark) {
+                refillNeeded.notify_one();
+            }
+            return material;
+        }
+    }
+
+    // Empty: take the next material in sequence, unless the refiller just queued it
+    lock_guard<mutex> generatorLock(generatorMutex);
+    {
+        lock_guard<mutex> lock(queueMutex);
+        if (!queue.empty()) {
+            KeyMaterial material = queue.front();
+            queue.pop_front();
+            handedOut++;
+            return material;
+        }
+    }
+    misses++;
+    handedOut++;
+    KeyMaterial material = generate();
+    refillNeeded.notify_one();
+    return material;
+}
+
+void KeyPool::refillLoop() {
+    unique_lock<mutex> lock(queueMutex);
+    while (true) {
+        refillNeeded.wait(lock, [this] { return stopping || queue.size() < lowWaterMark; });
+        if (stopping) return;
+
+        refills++;
+        while (!stopping && queue.size() < capacity) {
+            lock.unlock();
+            {
+                // Generate and enqueue under the generator lock so the queue stays in sequence order
+                // (configure() may have shrunk or reseeded the pool while unlocked)
+                lock_guard<mutex> generatorLock(generatorMutex);
+                bool full;
+                {
+                    lock_guard<mutex> queueLock(queueMutex);
+                    full = stopping || queue.size() >= capacity;
+                }
+                if (!full) {
+                    KeyMaterial material = generate();
+                    lock_guard<mutex> queueLock(queueMutex);
+                    queue.push_back(material);
+                }
+            }
+            lock.lock();
+        }
+    }
+}
+
+KeyPoolStats KeyPool::getStats() const {
+    KeyPoolStats stats;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stats.available = queue.size();
+        stats.capacity = capacity;
+        stats.lowWaterMark = lowWaterMark;
+        stats.seeded = seed != 0;
+    }
+    stats.handedOut = handedOut.load();
+    stats.generated = generated.load();
+    stats.refills = refills.load();
+    stats.misses = misses.load();
+    stats.generationSeconds = generationNanos.load() / 1e9;
+    return stats;
+}
@@ -0,0 +1,82 @@
+#ifndef KEYPOOL_H
+#define KEYPOOL_H
+
+#include "ElGamal.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+
+// Everything Block::Block needs from the random source: a fresh key pair and
+// the ephemeral exponent its payload is encrypted under
+struct KeyMaterial {
+    KeyPair keyPair;
+    long long sessionKey;   // In [100, p - 100]
+};
+
+struct KeyPoolStats {
+    size_t available;           // Material ready to hand out
+    size_t capacity;
+    size_t lowWaterMark;
+    long long handedOut;
+    long long generated;
+    long long refills;          // Background refill runs (low-water mark crossings)
+    long long misses;           // acquire() found the pool empty and generated inline
+    double generationSeconds;   // Total time spent generating material, all threads
+    bool seeded;                // Deterministic sequence
+};
+
+// Process-wide pool of pre-generated key material shared by every Computer, so
+// key generation never sits in front of mining. A background thread refills the
+// pool to capacity whenever it drops below the low-water mark; acquire() pops in
+// O(1) and only generates inline when the pool has run dry.
+//
+// All material comes from one generator in one sequence, whether it was made by
+// the refill thread or inline, so with a nonzero seed the n-th acquire() of a run
+// always returns the same key pair regardless of thread timing.
+class KeyPool {
+public:
+    static KeyPool& instance();
+
+    // Seed 0 draws from the clock. Changing the seed discards queued material so
+    // the handed-out sequence depends on the seed alone.
+    void configure(size_t capacity, size_t lowWaterMark, unsigned long long seed);
+
+    KeyMaterial acquire();
+    KeyPoolStats getStats() const;
+
+    ~KeyPool();
+
+private:
+    KeyPool();
+    KeyPool(const KeyPool&) = delete;
+    KeyPool& operator=(const KeyPool&) = delete;
+
+    KeyMaterial generate();   // Caller holds generatorMutex
+    void refillLoop();
+
+    // Lock order: generatorMutex before queueMutex
+    std::mutex generatorMutex;
+    std::mt19937_64 rng;
+    unsigned long long seed;
+
+    mutable std::mutex queueMutex;
+    std::condition_variable refillNeeded;
+    std::deque<KeyMaterial> queue;
+    size_t capacity;
+    size_t lowWaterMark;
+    bool stopping;
+
+    std::atomic<long long> handedOut;
+    std::atomic<long long> generated;
+    std::atomic<long long> refills;
+    std::atomic<long long> misses;
+    std::atomic<long long> generationNanos;
+
+    std::thread refiller;
+};
+
+#endif
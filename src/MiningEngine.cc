@@ -1,103 +1,340 @@
 #include "MiningEngine.h"
 #include "HashUtils.h"
 #include "ElGamal.h"
+#include "SHA256.h"
 #include <omnetpp.h>
 #include <sstream>
 #include <iostream>
 #include <chrono>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <cmath>
 
 using namespace omnetpp;
 
 MiningEngine::MiningEngine(int diff) {
-    difficulty = diff;
+    setDifficulty(diff);
     maxAttempts = 100000; // Limit for simulation
     showProgress = true;
     progressInterval = 5000; // Show progress every 5k attempts
+    useBatchHashing = true;
+    useMidstate = true;
+    threadCount = 1;
+    nonceSplit = SPLIT_CHUNKED;
+    chunkSize = 4096;
+    ownerId = -1;
+    priority = PRIORITY_NORMAL;
 }
 
 MiningResult MiningEngine::mineBlock(Block& block) {
-    MiningResult result;
+    MiningSession session;
+    beginMining(session, block);
+    currentJob = session.job;
+
+    // One slice covering every remaining nonce
+    mineSlice(session, INT_MAX);
+    currentJob.reset();
+
+    if (session.status == SLICE_FOUND) {
+        block.setNonce(session.result.goldenNonce);
+    }
+    return session.result;
+}
+
+void MiningEngine::beginMining(MiningSession& session, const Block& block) {
+    session.block = block;
+    session.nextNonce = 0;
+    session.status = SLICE_PENDING;
+    session.job = MiningPool::instance().createJob(ownerId, block.getBlockNumber(), priority);
+
+    MiningResult& result = session.result;
     result.success = false;
     result.goldenNonce = 0;
+    result.blockHash = Digest::zero();
     result.attempts = 0;
-    
-    auto startTime = std::chrono::high_resolution_clock::now();
-    
+    result.miningTimeMs = 0.0;
+    result.hashRate = 0.0;
+    result.cancelled = false;
+    result.threadsUsed = threadCount;
+    result.threadAttempts.assign(threadCount, 0);
+
     EV << "🔨 Mining block " << block.getBlockNumber() 
-       << " with difficulty " << difficulty << "...\n";
+       << " with difficulty " << difficulty << " bits...\n";
     
-    std::string target = HashUtils::generateTarget(difficulty);
-    EV << "🎯 Target: " << target.substr(0, 20) << "...\n";
+    EV << "🎯 Target: " << target.toHex().substr(0, 20) << "...\n";
     
+    EV << "🧮 SHA-256 backend: " << SHA256::backendName(SHA256::getBackend())
+       << (useBatchHashing && SHA256::getLaneCount() > 1 ? " (batched)" : "")
+       << (useMidstate ? ", midstate cached" : "")
+       << ", " << threadCount << " thread(s)" << "\n";
+
+    if (useMidstate) {
+        std::string prefix = block.getMiningHeaderPrefix();
+        SHA256::computeMidstate((const uint8_t*)prefix.data(), prefix.size(), session.midstate);
+    }
+}
+
+MiningSliceStatus MiningEngine::mineSlice(MiningSession& session, int nonceBudget) {
+    if (session.status != SLICE_PENDING) {
+        return session.status;
+    }
+
+    MiningResult& result = session.result;
+    if (session.job->isCancelled()) {
+        session.status = SLICE_CANCELLED;
+        finishMining(session);
+        return session.status;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    int firstNonce = session.nextNonce;
+    int lastNonce = (int)std::min<long long>((long long)firstNonce + std::max(1, nonceBudget) - 1, maxAttempts);
+
     // Mining loop - find golden nonce
-    for (int nonce = 0; nonce <= maxAttempts; nonce++) {
-        result.attempts++;
-        
-        // Calculate hash with current nonce
-        std::string blockHash = calculateBlockHash(block, nonce);
-        
-        // Check if hash meets difficulty target
-        if (HashUtils::isHashValid(blockHash, difficulty)) {
-            // Golden nonce found!
-            result.success = true;
-            result.goldenNonce = nonce;
-            result.blockHash = blockHash;
-            
-            // Update block with golden nonce
-            block.setNonce(nonce);
-            
-            auto endTime = std::chrono::high_resolution_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
-            result.miningTimeMs = duration.count();
-            result.hashRate = HashUtils::calculateHashRate(result.attempts, result.miningTimeMs / 1000.0);
-            
-            EV << "⛏️  GOLDEN NONCE FOUND!\n"
-               << "   Nonce: " << result.goldenNonce << "\n"
-               << "   Hash: " << result.blockHash << "\n"
-               << "   Attempts: " << result.attempts << "\n"
-               << "   Mining time: " << result.miningTimeMs << " ms\n"
-               << "   Hash rate: " << std::fixed << std::setprecision(2) 
-               << result.hashRate << " H/s\n";
-            
-            return result;
-        }
-        
-        // Show progress
-        if (showProgress && nonce % progressInterval == 0 && nonce > 0) {
-            EV << "   ⚙️ Attempt " << nonce << ": hash " 
-               << blockHash.substr(0, 10) << "... (not valid)\n";
-        }
+    int goldenNonce;
+    if (threadCount > 1) {
+        goldenNonce = searchParallel(session.block, session.midstate, firstNonce, lastNonce, result, session.job);
+    } else {
+        int attempts = 0;
+        goldenNonce = searchRange(session.block, session.midstate, firstNonce, lastNonce, attempts,
+                                  showProgress, session.job->getCancelFlag());
+        result.attempts += attempts;
+        result.threadAttempts[0] += attempts;
     }
-    
-    // Mining failed - no golden nonce found within limit
+    session.nextNonce = lastNonce + 1;
+
     auto endTime = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
-    result.miningTimeMs = duration.count();
+    result.miningTimeMs += std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+    if (goldenNonce >= 0) {
+        session.status = SLICE_FOUND;
+        result.goldenNonce = goldenNonce;
+    } else if (session.job->isCancelled()) {
+        session.status = SLICE_CANCELLED;
+    } else if (lastNonce >= maxAttempts) {
+        session.status = SLICE_EXHAUSTED;
+    }
+
+    if (session.status != SLICE_PENDING) {
+        finishMining(session);
+    }
+    return session.status;
+}
+
+void MiningEngine::abortMining(MiningSession& session) {
+    if (session.status != SLICE_PENDING) {
+        return;
+    }
+    session.job->cancel();
+    session.status = SLICE_CANCELLED;
+    finishMining(session);
+}
+
+void MiningEngine::finishMining(MiningSession& session) {
+    MiningResult& result = session.result;
     result.hashRate = HashUtils::calculateHashRate(result.attempts, result.miningTimeMs / 1000.0);
-    
-    EV << "❌ Mining failed! No golden nonce found within " 
-       << maxAttempts << " attempts\n";
-    
-    return result;
+    result.cancelled = session.status == SLICE_CANCELLED;
+    session.job.reset();
+
+    if (session.status == SLICE_FOUND) {
+        // Golden nonce found!
+        result.success = true;
+        result.blockHash = calculateBlockHash(session.block, result.goldenNonce);
+
+        // Update block with golden nonce
+        session.block.setNonce(result.goldenNonce);
+
+        EV << "⛏️  GOLDEN NONCE FOUND!\n"
+           << "   Nonce: " << result.goldenNonce << "\n"
+           << "   Hash: " << result.blockHash.toHex() << "\n"
+           << "   Attempts: " << result.attempts << "\n"
+           << "   Mining time: " << result.miningTimeMs << " ms\n"
+           << "   Hash rate: " << std::fixed << std::setprecision(2)
+           << result.hashRate << " H/s\n";
+        if (threadCount > 1) {
+            for (int i = 0; i < threadCount; i++) {
+                EV << "   Thread " << i << ": " << result.threadAttempts[i] << " attempts\n";
+            }
+        }
+    } else if (result.cancelled) {
+        EV << "🛑 Mining cancelled after " << result.attempts << " attempts\n";
+    } else {
+        // Mining failed - no golden nonce found within limit
+        EV << "❌ Mining failed! No golden nonce found within " 
+           << maxAttempts << " attempts\n";
+    }
 }
 
-std::string MiningEngine::calculateBlockHash(const Block& block, int nonce) {
-    std::stringstream ss;
-    
-    // Construct block data for hashing - same as Block::calculateMiningHash but with custom nonce
-    ss << block.getBlockNumber() << "|"
-       << block.getEncryptedData() << "|"
-       << block.getPreviousBlockRef() << "|"
-       << ElGamal::publicKeyToString(block.getPublicKey()) << "|"
-       << nonce; // This is the mining variable!
-    
-    return HashUtils::calculateSHA256(ss.str());
+int MiningEngine::searchRange(const Block& block, const SHA256::Midstate& midstate, int firstNonce, int lastNonce,
+                              int& attempts, bool logProgress, const std::atomic<bool>& cancelFlag) const {
+    return useMidstate ? searchWithMidstate(midstate, firstNonce, lastNonce, attempts, logProgress, cancelFlag)
+                       : searchFullRehash(block, firstNonce, lastNonce, attempts, logProgress, cancelFlag);
+}
+
+// Reference path: re-serializes the whole header for every nonce
+int MiningEngine::searchFullRehash(const Block& block, int firstNonce, int lastNonce,
+                                   int& attempts, bool logProgress, const std::atomic<bool>& cancelFlag) const {
+    // Nonces hashed per iteration: one per SIMD lane when batching
+    int batchSize = useBatchHashing ? SHA256::getLaneCount() : 1;
+    std::vector<std::string> inputs;
+
+    for (int batchStart = firstNonce; batchStart <= lastNonce; batchStart += batchSize) {
+        if (cancelFlag.load(std::memory_order_relaxed)) return -1;
+
+        int lanes = std::min(batchSize, lastNonce - batchStart + 1);
+        inputs.resize(lanes);
+        for (int lane = 0; lane < lanes; lane++) {
+            inputs[lane] = block.getMiningHashInput(batchStart + lane);
+        }
+
+        std::vector<Digest> hashes = HashUtils::calculateSHA256Batch(inputs);
+
+        // Lanes are checked in nonce order so the lowest golden nonce wins
+        for (int lane = 0; lane < lanes; lane++) {
+            int nonce = batchStart + lane;
+            attempts++;
+
+            if (hashes[lane].meetsTarget(target)) {
+                return nonce;
+            }
+
+            // Show progress
+            if (logProgress && nonce % progressInterval == 0 && nonce > 0) {
+                EV << "   ⚙️ Attempt " << nonce << ": hash "
+                   << hashes[lane].toHex().substr(0, 10) << "... (not valid)\n";
+            }
+        }
+    }
+    return -1;
+}
+
+// Starts from the midstate of the nonce-independent header prefix; per nonce only
+// writes the nonce digits into preallocated lane buffers and finishes the last
+// block(s). Nothing inside the nonce loop touches the heap (progress logging aside).
+int MiningEngine::searchWithMidstate(const SHA256::Midstate& midstate, int firstNonce, int lastNonce,
+                                     int& attempts, bool logProgress, const std::atomic<bool>& cancelFlag) const {
+    int batchSize = useBatchHashing ? SHA256::getLaneCount() : 1;
+    char nonceDigits[SHA256::MAX_LANES][12];
+    const uint8_t* suffixes[SHA256::MAX_LANES];
+    size_t suffixLengths[SHA256::MAX_LANES];
+    Digest digests[SHA256::MAX_LANES];
+    for (int lane = 0; lane < SHA256::MAX_LANES; lane++) {
+        suffixes[lane] = (const uint8_t*)nonceDigits[lane];
+    }
+
+    for (int batchStart = firstNonce; batchStart <= lastNonce; batchStart += batchSize) {
+        if (cancelFlag.load(std::memory_order_relaxed)) return -1;
+
+        int lanes = std::min(batchSize, lastNonce - batchStart + 1);
+        for (int lane = 0; lane < lanes; lane++) {
+            suffixLengths[lane] = formatNonce(batchStart + lane, nonceDigits[lane]);
+        }
+
+        SHA256::finishMidstateBatch(midstate, suffixes, suffixLengths, lanes, (uint8_t*)digests);
+
+        for (int lane = 0; lane < lanes; lane++) {
+            int nonce = batchStart + lane;
+            const Digest& digest = digests[lane];
+            attempts++;
+
+            if (digest.meetsTarget(target)) {
+                return nonce;
+            }
+
+            if (logProgress && nonce % progressInterval == 0 && nonce > 0) {
+                EV << "   ⚙️ Attempt " << nonce << ": hash "
+                   << HashUtils::toHex(digest.bytes, 5) << "... (not valid)\n";
+            }
+        }
+    }
+    return -1;
+}
+
+// Every task stops once the next range it would claim starts above the best
+// nonce found so far. Ranges are claimed in increasing order, so every nonce below
+// the reported winner has been checked and the result does not depend on timing.
+int MiningEngine::searchParallel(const Block& block, const SHA256::Midstate& midstate, int firstNonce, int lastNonce,
+                                 MiningResult& result, const std::shared_ptr<MiningJob>& job) {
+    const int workers = threadCount;
+    const long long stride = (nonceSplit == SPLIT_INTERLEAVED) ? SHA256::getLaneCount() : chunkSize;
+    const std::atomic<bool>& cancelFlag = job->getCancelFlag();
+
+    std::atomic<int> bestNonce(INT_MAX);
+    std::atomic<long long> nextChunk(firstNonce);
+    std::vector<int> threadAttempts(workers, 0);
+
+    auto worker = [&](int id) {
+        int attempts = 0;  // Task-local to avoid false sharing
+        for (long long round = 0; ; round++) {
+            long long start = (nonceSplit == SPLIT_INTERLEAVED)
+                ? firstNonce + (round * workers + id) * stride
+                : nextChunk.fetch_add(stride);
+            if (start > lastNonce || start > bestNonce.load() || cancelFlag.load()) break;
+
+            int end = (int)std::min<long long>(start + stride - 1, lastNonce);
+            int found = searchRange(block, midstate, (int)start, end, attempts, false, cancelFlag);
+            if (found >= 0) {
+                int current = bestNonce.load();
+                while (found < current && !bestNonce.compare_exchange_weak(current, found)) {}
+                break;
+            }
+        }
+        threadAttempts[id] = attempts;
+    };
+
+    // Tasks 1..N-1 go to the shared pool; the calling thread runs task 0 itself so
+    // the search always progresses even when the pool is busy with other nodes
+    MiningPool& pool = MiningPool::instance();
+    for (int id = 1; id < workers; id++) {
+        pool.submit(job, [&worker, id] { worker(id); });
+    }
+    worker(0);
+    pool.wait(job);
+
+    result.threadAttempts.resize(workers, 0);
+    for (int id = 0; id < workers; id++) {
+        result.threadAttempts[id] += threadAttempts[id];
+        result.attempts += threadAttempts[id];
+    }
+
+    int best = bestNonce.load();
+    return best == INT_MAX ? -1 : best;
+}
+
+size_t MiningEngine::formatNonce(int nonce, char* out) {
+    char reversed[12];
+    size_t length = 0;
+    unsigned int value = nonce < 0 ? 0u - (unsigned int)nonce : (unsigned int)nonce;
+    do {
+        reversed[length++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    size_t pos = 0;
+    if (nonce < 0) out[pos++] = '-';
+    while (length > 0) out[pos++] = reversed[--length];
+    return pos;
+}
+
+double MiningEngine::getExpectedAttempts() const {
+    double targetValue = 0.0;
+    for (size_t i = 0; i < Digest::SIZE; i++) {
+        targetValue = targetValue * 256.0 + target.bytes[i];
+    }
+    return std::ldexp(1.0, 256) / (targetValue + 1.0);
+}
+
+Digest MiningEngine::calculateBlockHash(const Block& block, int nonce) {
+    // Same header serialization as Block::calculateMiningHash but with custom nonce
+    return HashUtils::calculateSHA256(block.getMiningHashInput(nonce));
 }
 
 bool MiningEngine::validateMinedBlock(const Block& block) {
     // Recalculate hash with block's nonce
-    std::string recalculatedHash = calculateBlockHash(block, block.getNonce());
+    Digest recalculatedHash = calculateBlockHash(block, block.getNonce());
     
-    // Verify hash meets difficulty requirement
-    return HashUtils::isHashValid(recalculatedHash, difficulty);
+    // Verify hash meets the target
+    return HashUtils::isHashValid(recalculatedHash, target);
 }
\ No newline at end of file
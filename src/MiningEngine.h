@@ -2,39 +2,123 @@
 #define MININGENGINE_H
 
 #include "Block.h"
+#include "Digest.h"
+#include "HashUtils.h"
+#include "SHA256.h"
+#include "MiningPool.h"
 #include <string>
 #include <chrono>
+#include <vector>
+#include <atomic>
 
 struct MiningResult {
     bool success;
     int goldenNonce;
-    std::string blockHash;
+    Digest blockHash;
     int attempts;
     double miningTimeMs;
-    double hashRate;
+    double hashRate;                 // Aggregate over all worker threads
+    bool cancelled;
+    int threadsUsed;
+    std::vector<int> threadAttempts; // Nonces hashed by each worker
+};
+
+enum MiningSliceStatus {
+    SLICE_PENDING = 0,      // More nonces left; call mineSlice again
+    SLICE_FOUND = 1,
+    SLICE_EXHAUSTED = 2,    // maxAttempts reached without a golden nonce
+    SLICE_CANCELLED = 3
+};
+
+// Resumable nonce search over one block. Each mineSlice call hashes a bounded
+// range and returns, so a caller can interleave mining with other events.
+struct MiningSession {
+    Block block;                        // Header being mined; nonce set once found
+    SHA256::Midstate midstate;
+    int nextNonce;                      // First nonce of the next slice
+    MiningSliceStatus status;
+    MiningResult result;                // Attempts and CPU time accumulate across slices
+    std::shared_ptr<MiningJob> job;     // Pool job tagged with owner and height for cancellation
+};
+
+// How the nonce space is divided between worker threads
+enum NonceSplit {
+    SPLIT_CHUNKED = 0,      // Workers claim consecutive chunks from a shared counter
+    SPLIT_INTERLEAVED = 1   // Worker i takes SIMD batches i, i+N, i+2N, ...
 };
 
 class MiningEngine {
 private:
-    int difficulty;
+    int difficulty;         // Leading zero bits required
+    Digest target;          // 256-bit target the digest must not exceed
     int maxAttempts;
     bool showProgress;
     int progressInterval;
+    bool useBatchHashing;   // Hash one nonce per SIMD lane per iteration
+    bool useMidstate;       // Cache the header prefix midstate, rehash only the nonce tail
+    int threadCount;
+    NonceSplit nonceSplit;
+    int chunkSize;          // Nonces per claimed chunk in SPLIT_CHUNKED mode
+    int ownerId;            // Node id used to tag pool jobs for cancellation
+    MiningPriority priority;
+    std::shared_ptr<MiningJob> currentJob;
+
+    // Nonce search over [firstNonce, lastNonce]; returns the golden nonce or -1.
+    // Safe to run concurrently: only attempts is written, and only logProgress logs.
+    int searchRange(const Block& block, const SHA256::Midstate& midstate, int firstNonce, int lastNonce,
+                    int& attempts, bool logProgress, const std::atomic<bool>& cancelFlag) const;
+    int searchFullRehash(const Block& block, int firstNonce, int lastNonce, int& attempts, bool logProgress,
+                         const std::atomic<bool>& cancelFlag) const;
+    int searchWithMidstate(const SHA256::Midstate& midstate, int firstNonce, int lastNonce,
+                           int& attempts, bool logProgress, const std::atomic<bool>& cancelFlag) const;
+
+    // Splits [firstNonce, lastNonce] into threadCount tasks on the shared
+    // MiningPool and returns the lowest golden nonce in the range, independent
+    // of thread timing
+    int searchParallel(const Block& block, const SHA256::Midstate& midstate, int firstNonce, int lastNonce,
+                       MiningResult& result, const std::shared_ptr<MiningJob>& job);
+
+    void finishMining(MiningSession& session);
 
 public:
-    MiningEngine(int diff = 4);
+    MiningEngine(int diff = HashUtils::DEFAULT_DIFFICULTY_BITS);
     
-    // Main mining function
+    // Main mining function: runs the whole nonce search before returning
     MiningResult mineBlock(Block& block);
+
+    // Event-sliced mining: begin once, then hash at most nonceBudget nonces per call
+    void beginMining(MiningSession& session, const Block& block);
+    MiningSliceStatus mineSlice(MiningSession& session, int nonceBudget);
+    void abortMining(MiningSession& session);
     
     // Configuration methods
-    void setDifficulty(int diff) { difficulty = diff; }
+    void setDifficulty(int diffBits) { difficulty = diffBits; target = HashUtils::generateTarget(diffBits); }
+    void setTarget(const Digest& newTarget) { target = newTarget; difficulty = newTarget.leadingZeroBits(); }
+    const Digest& getTarget() const { return target; }
+    int getDifficulty() const { return difficulty; }
+
+    // Mean number of hashes needed to meet the current target (2^256 / (target + 1))
+    double getExpectedAttempts() const;
     void setMaxAttempts(int maxAtt) { maxAttempts = maxAtt; }
     void setShowProgress(bool show) { showProgress = show; }
+    void setUseBatchHashing(bool batch) { useBatchHashing = batch; }
+    void setUseMidstate(bool midstate) { useMidstate = midstate; }
+    void setThreadCount(int threads) { threadCount = threads < 1 ? 1 : threads; }  // Parallel tasks per search
+    void setNonceSplit(NonceSplit split) { nonceSplit = split; }
+    void setChunkSize(int nonces) { chunkSize = nonces < 1 ? 1 : nonces; }
+    int getThreadCount() const { return threadCount; }
+
+    // Cooperative cancellation: workers stop at their next batch boundary
+    void cancel() { if (currentJob) currentJob->cancel(); }
+    void setOwnerId(int id) { ownerId = id; }
+    void setPriority(MiningPriority prio) { priority = prio; }
     
     // Utility methods
-    std::string calculateBlockHash(const Block& block, int nonce);
+    Digest calculateBlockHash(const Block& block, int nonce);
     bool validateMinedBlock(const Block& block);
+
+    // Writes the decimal nonce into out (at least 12 bytes); returns its length
+    static size_t formatNonce(int nonce, char* out);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "MiningPool.h"
+#include <algorithm>
+
+using namespace std;
+
+int MiningPool::configuredWorkers = 0;
+
+namespace {
+// Index of the pool worker running on this thread, -1 for outside threads
+thread_local int currentWorker = -1;
+}
+
+MiningPool& MiningPool::instance() {
+    static MiningPool pool(configuredWorkers > 0 ? configuredWorkers
+                                                 : max(1, (int)thread::hardware_concurrency()));
+    return pool;
+}
+
+void MiningPool::configure(int workerCount) {
+    configuredWorkers = workerCount;
+}
+
+MiningPool::MiningPool(int workerCount)
+    : stopping(false), queued(0), nextQueue(0), tasksSubmitted(0), tasksExecuted(0),
+      tasksSkipped(0), steals(0), jobsCancelled(0), busyNanos(0), peakQueued(0),
+      startTime(chrono::steady_clock::now()) {
+    for (int i = 0; i < workerCount; i++) {
+        queues.emplace_back(new WorkerQueue());
+    }
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back(&MiningPool::workerLoop, this, i);
+    }
+}
+
+MiningPool::~MiningPool() {
+    {
+        lock_guard<mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+shared_ptr<MiningJob> MiningPool::createJob(int ownerId, int height, MiningPriority priority) {
+    auto job = make_shared<MiningJob>(ownerId, height, priority);
+
+    lock_guard<mutex> lock(jobsMutex);
+    liveJobs.erase(remove_if(liveJobs.begin(), liveJobs.end(),
+                             [](const weak_ptr<MiningJob>& j) { return j.expired(); }),
+                   liveJobs.end());
+    liveJobs.push_back(job);
+    return job;
+}
+
+void MiningPool::submit(const shared_ptr<MiningJob>& job, Task task) {
+    {
+        lock_guard<mutex> lock(job->mutex);
+        job->pendingTasks++;
+    }
+
+    // Tasks spawned by a worker stay local; outside submissions are spread round-robin
+    int target = currentWorker >= 0 ? currentWorker : (int)(nextQueue++ % queues.size());
+    {
+        lock_guard<mutex> lock(queues[target]->mutex);
+        queues[target]->levels[job->priority].push_back(Entry{job, move(task)});
+    }
+
+    tasksSubmitted++;
+    size_t depth = ++queued;
+    size_t peak = peakQueued.load();
+    while (depth > peak && !peakQueued.compare_exchange_weak(peak, depth)) {}
+
+    {
+        lock_guard<mutex> lock(sleepMutex);
+    }
+    workAvailable.notify_one();
+}
+
+void MiningPool::wait(const shared_ptr<MiningJob>& job) {
+    unique_lock<mutex> lock(job->mutex);
+    job->done.wait(lock, [&job] { return job->pendingTasks == 0; });
+}
+
+int MiningPool::cancelJobs(int ownerId, int height) {
+    int count = 0;
+    lock_guard<mutex> lock(jobsMutex);
+    for (auto& weak : liveJobs) {
+        shared_ptr<MiningJob> job = weak.lock();
+        if (job && job->ownerId == ownerId && job->height == height && !job->isCancelled()) {
+            job->cancel();
+            count++;
+        }
+    }
+    jobsCancelled += count;
+    return count;
+}
+
+MiningPoolStats MiningPool::getStats() const {
+    MiningPoolStats stats;
+    stats.workers = getWorkerCount();
+    stats.tasksSubmitted = tasksSubmitted.load();
+    stats.tasksExecuted = tasksExecuted.load();
+    stats.tasksSkipped = tasksSkipped.load();
+    stats.steals = steals.load();
+    stats.jobsCancelled = jobsCancelled.load();
+    stats.queueDepth = queued.load();
+    stats.peakQueueDepth = peakQueued.load();
+
+    double uptimeNanos = (double)chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now() - startTime).count();
+    stats.utilization = uptimeNanos > 0 ? busyNanos.load() / (uptimeNanos * stats.workers) : 0.0;
+    return stats;
+}
+
+void MiningPool::workerLoop(int index) {
+    currentWorker = index;
+
+    while (true) {
+        Entry entry;
+        bool found = false;
+
+        // Highest priority first; own deque before stealing at the same level
+        for (int level = PRIORITY_HIGH; level >= PRIORITY_LOW && !found; level--) {
+            found = popLocal(index, level, entry) || steal(index, level, entry);
+        }
+
+        if (found) {
+            queued--;
+            run(entry);
+            continue;
+        }
+
+        unique_lock<mutex> lock(sleepMutex);
+        if (stopping) return;
+        workAvailable.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
+
+bool MiningPool::popLocal(int index, int level, Entry& entry) {
+    WorkerQueue& queue = *queues[index];
+    lock_guard<mutex> lock(queue.mutex);
+    if (queue.levels[level].empty()) return false;
+
+    // LIFO on the owner's end keeps recently spawned work cache-warm
+    entry = move(queue.levels[level].back());
+    queue.levels[level].pop_back();
+    return true;
+}
+
+bool MiningPool::steal(int thief, int level, Entry& entry) {
+    int count = (int)queues.size();
+    for (int offset = 1; offset < count; offset++) {
+        WorkerQueue& victim = *queues[(thief + offset) % count];
+        lock_guard<mutex> lock(victim.mutex);
+        if (victim.levels[level].empty()) continue;
+
+        // FIFO from the victim's far end takes the oldest (largest) work
+        entry = move(victim.levels[level].front());
+        victim.levels[level].pop_front();
+        steals++;
+        return true;
+    }
+    return false;
+}
+
+void MiningPool::run(Entry& entry) {
+    if (entry.job->isCancelled()) {
+        tasksSkipped++;
+    } else {
+        auto start = chrono::steady_clock::now();
+        entry.task();
+        busyNanos += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        tasksExecuted++;
+    }
+    finishTask(entry.job);
+}
+
+void MiningPool::finishTask(const shared_ptr<MiningJob>& job) {
+    lock_guard<mutex> lock(job->mutex);
+    if (--job->pendingTasks == 0) {
+        job->done.notify_all();
+    }
+}
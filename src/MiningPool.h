@@ -0,0 +1,129 @@
+#ifndef MININGPOOL_H
+#define MININGPOOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum MiningPriority {
+    PRIORITY_LOW = 0,
+    PRIORITY_NORMAL = 1,
+    PRIORITY_HIGH = 2
+};
+
+// One mining run (a block at a given height for a given node). All tasks of a
+// job share its cancellation flag and completion counter.
+class MiningJob {
+private:
+    int ownerId;
+    int height;
+    MiningPriority priority;
+    std::atomic<bool> cancelled;
+    int pendingTasks;
+    std::mutex mutex;
+    std::condition_variable done;
+
+    friend class MiningPool;
+
+public:
+    MiningJob(int owner, int blockHeight, MiningPriority prio)
+        : ownerId(owner), height(blockHeight), priority(prio), cancelled(false), pendingTasks(0) {}
+
+    int getOwnerId() const { return ownerId; }
+    int getHeight() const { return height; }
+    MiningPriority getPriority() const { return priority; }
+
+    void cancel() { cancelled = true; }
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+    const std::atomic<bool>& getCancelFlag() const { return cancelled; }
+};
+
+struct MiningPoolStats {
+    int workers;
+    long long tasksSubmitted;
+    long long tasksExecuted;
+    long long tasksSkipped;     // Dequeued after their job was cancelled
+    long long steals;
+    long long jobsCancelled;
+    size_t queueDepth;          // Tasks currently waiting
+    size_t peakQueueDepth;
+    double utilization;         // Busy time / (workers * uptime)
+};
+
+// Process-wide work-stealing executor shared by every MiningEngine, so that
+// many Computer modules never oversubscribe the machine. Each worker owns a
+// deque per priority level; workers prefer higher priorities over locality and
+// steal from the front of other workers' deques when their own run dry.
+class MiningPool {
+public:
+    typedef std::function<void()> Task;
+
+    static MiningPool& instance();
+
+    // Must be called before the first instance() to override the hardware size
+    static void configure(int workerCount);
+
+    std::shared_ptr<MiningJob> createJob(int ownerId, int height, MiningPriority priority);
+    void submit(const std::shared_ptr<MiningJob>& job, Task task);
+    void wait(const std::shared_ptr<MiningJob>& job);
+
+    // Cancel every live job of ownerId mining at height; returns how many were cancelled
+    int cancelJobs(int ownerId, int height);
+
+    int getWorkerCount() const { return (int)workers.size(); }
+    MiningPoolStats getStats() const;
+
+    ~MiningPool();
+
+private:
+    struct Entry {
+        std::shared_ptr<MiningJob> job;
+        Task task;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Entry> levels[PRIORITY_HIGH + 1];
+    };
+
+    explicit MiningPool(int workerCount);
+    MiningPool(const MiningPool&) = delete;
+    MiningPool& operator=(const MiningPool&) = delete;
+
+    void workerLoop(int index);
+    bool popLocal(int index, int level, Entry& entry);
+    bool steal(int thief, int level, Entry& entry);
+    void run(Entry& entry);
+    void finishTask(const std::shared_ptr<MiningJob>& job);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+    std::mutex sleepMutex;
+    std::condition_variable workAvailable;
+    std::atomic<bool> stopping;
+    std::atomic<size_t> queued;
+    std::atomic<unsigned> nextQueue;
+
+    std::mutex jobsMutex;
+    std::vector<std::weak_ptr<MiningJob>> liveJobs;
+
+    std::atomic<long long> tasksSubmitted;
+    std::atomic<long long> tasksExecuted;
+    std::atomic<long long> tasksSkipped;
+    std::atomic<long long> steals;
+    std::atomic<long long> jobsCancelled;
+    std::atomic<long long> busyNanos;
+    std::atomic<size_t> peakQueued;
+    std::chrono::steady_clock::time_point startTime;
+
+    static int configuredWorkers;
+};
+
+#endif
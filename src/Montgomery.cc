@@ -0,0 +1,31 @@
+#include "Montgomery.h"
+#include <stdexcept>
+
+using namespace std;
+
+MontgomeryContext::MontgomeryContext(uint64_t n) {
+    if (n < 3 || (n & 1) == 0 || n >= (1ULL << 63)) {
+        throw invalid_argument("Montgomery modulus must be odd and in [3, 2^63)");
+    }
+    modulus = n;
+
+    // Newton iteration doubles the correct low bits each step: 3 -> 6 -> ... -> 96 >= 64
+    uint64_t inverse = n;  // n * n == 1 mod 8 for odd n
+    for (int i = 0; i < 5; i++) {
+        inverse *= 2 - n * inverse;
+    }
+    negInverse = 0 - inverse;
+
+    rModN = (0 - n) % n;  // 2^64 mod n
+    rSquared = (uint64_t)((unsigned __int128)rModN * rModN % n);
+}
+
+uint64_t MontgomeryContext::pow(uint64_t montBase, uint64_t exp) const {
+    uint64_t result = rModN;
+    while (exp > 0) {
+        if (exp & 1) result = multiply(result, montBase);
+        montBase = multiply(montBase, montBase);
+        exp >>= 1;
+    }
+    return result;
+}
@@ -0,0 +1,51 @@
+#ifndef MONTGOMERY_H
+#define MONTGOMERY_H
+
+#include <cstdint>
+
+// Montgomery arithmetic modulo an odd n < 2^63 with R = 2^64. A residue x is
+// held as x*R mod n; multiply() then costs three 64-bit multiplies and a
+// conditional subtract instead of the 128-bit division behind (__int128)a*b % n.
+class MontgomeryContext {
+private:
+    uint64_t modulus;
+    uint64_t negInverse;   // -n^-1 mod 2^64
+    uint64_t rSquared;     // R^2 mod n, used to enter Montgomery form
+    uint64_t rModN;        // R mod n, i.e. 1 in Montgomery form
+
+public:
+    // Unprepared context; isValid() is false
+    MontgomeryContext() : modulus(0), negInverse(0), rSquared(0), rModN(0) {}
+
+    // Throws invalid_argument unless n is odd and 3 <= n < 2^63
+    explicit MontgomeryContext(uint64_t n);
+
+    bool isValid() const { return modulus != 0; }
+    uint64_t getModulus() const { return modulus; }
+
+    // REDC: t * R^-1 mod n for t < n * R
+    uint64_t reduce(unsigned __int128 t) const {
+        uint64_t m = (uint64_t)t * negInverse;
+        unsigned __int128 sum = t + (unsigned __int128)m * modulus;  // Low 64 bits cancel
+        uint64_t result = (uint64_t)(sum >> 64);
+        return result >= modulus ? result - modulus : result;
+    }
+
+    // Product of two Montgomery-form residues, in Montgomery form
+    uint64_t multiply(uint64_t a, uint64_t b) const { return reduce((unsigned __int128)a * b); }
+
+    uint64_t toMontgomery(uint64_t x) const { return multiply(x % modulus, rSquared); }
+    uint64_t fromMontgomery(uint64_t x) const { return reduce(x); }
+    uint64_t one() const { return rModN; }
+
+    // base^exp with base and result in Montgomery form
+    uint64_t pow(uint64_t montBase, uint64_t exp) const;
+
+    // base^exp mod n on ordinary residues
+    uint64_t powMod(uint64_t base, uint64_t exp) const { return fromMontgomery(pow(toMontgomery(base), exp)); }
+
+    // a*b mod n on ordinary residues
+    uint64_t mulMod(uint64_t a, uint64_t b) const { return fromMontgomery(multiply(toMontgomery(a), toMontgomery(b))); }
+};
+
+#endif
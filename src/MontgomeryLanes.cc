@@ -0,0 +1,137 @@
+#include "MontgomeryLanes.h"
+#include "Montgomery.h"
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MONTGOMERY_LANES_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+#ifdef MONTGOMERY_LANES_X86
+
+struct LaneConstants {
+    __m256i modulus;      // n in every lane
+    __m256i negInverse;   // -n^-1 mod 2^32 in every lane
+    __m256i lowMask;      // 0xffffffff
+    __m256i one;          // 1
+};
+
+// REDC(a * b) for four residues a, b < n. t + m*n can exceed 64 bits when
+// n > 2^31, so the high halves are added separately: the low halves of t and
+// m*n sum to 0 mod 2^32, carrying exactly when the low half of t is nonzero.
+__attribute__((target("avx2")))
+inline __m256i montMultiply4(__m256i a, __m256i b, const LaneConstants& c) {
+    __m256i t = _mm256_mul_epu32(a, b);
+    __m256i m = _mm256_mul_epu32(t, c.negInverse);
+    __m256i mn = _mm256_mul_epu32(m, c.modulus);
+    __m256i lowZero = _mm256_cmpeq_epi64(_mm256_and_si256(t, c.lowMask), _mm256_setzero_si256());
+    __m256i carry = _mm256_andnot_si256(lowZero, c.one);
+    __m256i u = _mm256_add_epi64(_mm256_add_epi64(_mm256_srli_epi64(t, 32), _mm256_srli_epi64(mn, 32)), carry);
+    // u < 2n < 2^33, so the signed compare is safe
+    __m256i below = _mm256_cmpgt_epi64(c.modulus, u);
+    return _mm256_sub_epi64(u, _mm256_andnot_si256(below, c.modulus));
+}
+
+__attribute__((target("avx2")))
+void powModAVX2(const uint64_t* bases, size_t count, uint64_t exponent, uint64_t n, uint64_t* out) {
+    uint32_t inverse = (uint32_t)n;   // Correct to 3 bits; each Newton step doubles that
+    for (int i = 0; i < 4; i++) {
+        inverse *= 2 - (uint32_t)n * inverse;
+    }
+
+    LaneConstants c;
+    c.modulus = _mm256_set1_epi64x((long long)n);
+    c.negInverse = _mm256_set1_epi64x((long long)(uint32_t)(0 - inverse));
+    c.lowMask = _mm256_set1_epi64x(0xffffffffLL);
+    c.one = _mm256_set1_epi64x(1);
+
+    uint64_t rModN = (1ULL << 32) % n;
+    __m256i rSquared = _mm256_set1_epi64x((long long)(rModN * rModN % n));
+    __m256i montOne = _mm256_set1_epi64x((long long)rModN);
+    __m256i plainOne = c.one;
+
+    int topBit = exponent == 0 ? -1 : 63 - __builtin_clzll(exponent);
+
+    for (size_t start = 0; start < count; start += MontgomeryLanes::LANES) {
+        // Bases below R enter Montgomery form as REDC(x * R^2) without a division
+        alignas(32) uint64_t lane[MontgomeryLanes::LANES];
+        for (int i = 0; i < MontgomeryLanes::LANES; i++) {
+            uint64_t x = start + i < count ? bases[start + i] : 1;
+            lane[i] = x >> 32 == 0 ? x : x % n;
+        }
+        __m256i x0 = montMultiply4(_mm256_load_si256((const __m256i*)lane), rSquared, c);
+        __m256i x1 = montMultiply4(_mm256_load_si256((const __m256i*)(lane + 4)), rSquared, c);
+
+        // Two independent chains keep both multiply ports busy
+        __m256i r0 = montOne, r1 = montOne;
+        for (int bit = topBit; bit >= 0; bit--) {
+            r0 = montMultiply4(r0, r0, c);
+            r1 = montMultiply4(r1, r1, c);
+            if ((exponent >> bit) & 1) {
+                r0 = montMultiply4(r0, x0, c);
+                r1 = montMultiply4(r1, x1, c);
+            }
+        }
+
+        _mm256_store_si256((__m256i*)lane, montMultiply4(r0, plainOne, c));
+        _mm256_store_si256((__m256i*)(lane + 4), montMultiply4(r1, plainOne, c));
+        for (int i = 0; i < MontgomeryLanes::LANES && start + i < count; i++) {
+            out[start + i] = lane[i];
+        }
+    }
+}
+
+#endif
+
+void powModScalar(const uint64_t* bases, size_t count, uint64_t exponent, uint64_t n, uint64_t* out) {
+    MontgomeryContext ctx(n);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = ctx.powMod(bases[i], exponent);
+    }
+}
+
+} // namespace
+
+MontgomeryLanes::Backend MontgomeryLanes::activeBackend = MontgomeryLanes::detectBackend();
+
+MontgomeryLanes::Backend MontgomeryLanes::detectBackend() {
+#ifdef MONTGOMERY_LANES_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return BACKEND_AVX2;
+#endif
+    return BACKEND_SCALAR;
+}
+
+MontgomeryLanes::Backend MontgomeryLanes::getBackend() {
+    return activeBackend;
+}
+
+void MontgomeryLanes::setBackend(Backend backend) {
+    Backend supported = detectBackend();
+    activeBackend = backend > supported ? supported : backend;
+}
+
+const char* MontgomeryLanes::backendName(Backend backend) {
+    switch (backend) {
+        case BACKEND_AVX2: return "AVX2 x8";
+        default: return "scalar";
+    }
+}
+
+void MontgomeryLanes::powMod(const uint64_t* bases, size_t count, uint64_t exponent, uint64_t modulus,
+                             uint64_t* out) {
+    if (!supports(modulus)) {
+        throw invalid_argument("Lane kernel needs an odd modulus below 2^32");
+    }
+#ifdef MONTGOMERY_LANES_X86
+    if (activeBackend == BACKEND_AVX2) {
+        powModAVX2(bases, count, exponent, modulus, out);
+        return;
+    }
+#endif
+    powModScalar(bases, count, exponent, modulus, out);
+}
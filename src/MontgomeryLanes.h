@@ -0,0 +1,43 @@
+#ifndef MONTGOMERYLANES_H
+#define MONTGOMERYLANES_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Many bases raised to one shared exponent modulo an odd n < 2^32, in Montgomery
+// form with R = 2^32. Every base follows the same square-and-multiply schedule,
+// so the AVX2 kernel runs 8 bases at once (two registers of four 64-bit lanes,
+// one 32x32->64 vpmuludq per lane per product). The kernel is picked at runtime
+// from the CPU features; the scalar fallback uses MontgomeryContext per base.
+class MontgomeryLanes {
+public:
+    enum Backend {
+        BACKEND_SCALAR = 0,
+        BACKEND_AVX2 = 1     // 8 bases per kernel step
+    };
+
+    static const int LANES = 8;
+
+    // Batches below this size are not worth a kernel launch; callers stay scalar
+    static const size_t MIN_BATCH = 16;
+
+    // Moduli the kernel accepts: odd, 3 <= n < 2^32
+    static bool supports(uint64_t modulus) {
+        return (modulus & 1) && modulus >= 3 && modulus >> 32 == 0;
+    }
+
+    // out[i] = bases[i]^exponent mod n for i < count (bases need not be reduced;
+    // out may alias bases). Throws invalid_argument if !supports(modulus).
+    static void powMod(const uint64_t* bases, size_t count, uint64_t exponent, uint64_t modulus, uint64_t* out);
+
+    // Backend selection (defaults to the best the CPU supports)
+    static Backend getBackend();
+    static void setBackend(Backend backend);  // Clamped to what the CPU supports
+    static Backend detectBackend();
+    static const char* backendName(Backend backend);
+
+private:
+    static Backend activeBackend;
+};
+
+#endif
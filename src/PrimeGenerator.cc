@@ -1,25 +1,192 @@
 #include "PrimeGenerator.h"
+#include "Montgomery.h"
 #include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
 
 std::vector<long long> PrimeGenerator::largePrimes;
 std::mt19937 PrimeGenerator::rng(std::chrono::steady_clock::now().time_since_epoch().count());
+std::string PrimeGenerator::parameterPath;
+
+namespace {
+
+// Odd primes below the wheel bound; every candidate is sieved by these first
+const uint32_t WHEEL_BOUND = 2048;
+// Odd candidates examined per sieve window
+const size_t SIEVE_WINDOW = 2048;
+
+const std::vector<uint32_t>& wheelPrimes() {
+    static const std::vector<uint32_t> primes = [] {
+        std::vector<bool> composite(WHEEL_BOUND, false);
+        std::vector<uint32_t> found;
+        for (uint32_t i = 3; i < WHEEL_BOUND; i += 2) {
+            if (composite[i]) continue;
+            found.push_back(i);
+            for (uint32_t j = i * i; j < WHEEL_BOUND; j += 2 * i) {
+                composite[j] = true;
+            }
+        }
+        return found;
+    }();
+    return primes;
+}
+
+// 128x128 -> 256-bit product as (high, low) halves
+inline void multiplyWide(uint128 a, uint128 b, uint128& high, uint128& low) {
+    uint64_t a0 = (uint64_t)a, a1 = (uint64_t)(a >> 64);
+    uint64_t b0 = (uint64_t)b, b1 = (uint64_t)(b >> 64);
+    uint128 p00 = (uint128)a0 * b0;
+    uint128 p01 = (uint128)a0 * b1;
+    uint128 p10 = (uint128)a1 * b0;
+    uint128 p11 = (uint128)a1 * b1;
+    uint128 middle = (p00 >> 64) + (uint64_t)p01 + (uint64_t)p10;
+    low = (middle << 64) | (uint64_t)p00;
+    high = p11 + (p01 >> 64) + (p10 >> 64) + (middle >> 64);
+}
+
+// MontgomeryContext's interface with R = 2^128, for odd moduli up to 2^128 that
+// the 64-bit context cannot hold
+class WideMontgomery {
+private:
+    uint128 modulus;
+    uint128 negInverse;   // -n^-1 mod 2^128
+    uint128 rSquared;     // R^2 mod n
+    uint128 rModN;        // R mod n
+
+    uint128 addMod(uint128 a, uint128 b) const {
+        uint128 sum = a + b;
+        return (sum < a || sum >= modulus) ? sum - modulus : sum;
+    }
+
+public:
+    explicit WideMontgomery(uint128 n) : modulus(n) {
+        // Newton iteration doubles the correct low bits: 3 (n*n = 1 mod 8) -> 192
+        uint128 inverse = n;
+        for (int i = 0; i < 6; i++) {
+            inverse *= 2 - n * inverse;
+        }
+        negInverse = (uint128)0 - inverse;
+        rModN = ((uint128)0 - n) % n;
+        rSquared = rModN;
+        for (int i = 0; i < 128; i++) {
+            rSquared = addMod(rSquared, rSquared);
+        }
+    }
+
+    uint128 reduce(uint128 high, uint128 low) const {
+        uint128 m = low * negInverse;
+        uint128 mnHigh, mnLow;
+        multiplyWide(m, modulus, mnHigh, mnLow);
+        uint128 carry = (low != 0) ? 1 : 0;  // low + mnLow is 0 mod 2^128
+        uint128 result = high + mnHigh;
+        bool overflow = result < high;
+        result += carry;
+        overflow |= result < carry;
+        return (overflow || result >= modulus) ? result - modulus : result;
+    }
+
+    uint128 multiply(uint128 a, uint128 b) const {
+        uint128 high, low;
+        multiplyWide(a, b, high, low);
+        return reduce(high, low);
+    }
+
+    uint128 toMontgomery(uint128 x) const { return multiply(x % modulus, rSquared); }
+    uint128 one() const { return rModN; }
+
+    uint128 pow(uint128 montBase, uint128 exp) const {
+        uint128 result = rModN;
+        while (exp > 0) {
+            if (exp & 1) result = multiply(result, montBase);
+            montBase = multiply(montBase, montBase);
+            exp >>= 1;
+        }
+        return result;
+    }
+};
+
+// One Miller-Rabin round: n - 1 = d * 2^s, base a is a witness unless
+// a^d = 1 or a^(d * 2^r) = -1 for some r < s
+template <typename Context, typename Word>
+bool millerRabinRound(const Context& ctx, Word n, Word d, int s, Word a) {
+    Word one = ctx.one();
+    Word minusOne = ctx.toMontgomery(n - 1);
+    Word x = ctx.pow(ctx.toMontgomery(a), d);
+    if (x == one || x == minusOne) return true;
+    for (int r = 1; r < s; r++) {
+        x = ctx.multiply(x, x);
+        if (x == minusOne) return true;
+        if (x == one) return false;
+    }
+    return false;
+}
+
+// Bases 2..37 are a deterministic test for every n < 3.3 * 10^24
+const uint64_t DETERMINISTIC_BASES[12] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+
+// Miller-Rabin only; n must be odd, > WHEEL_BOUND and free of wheel factors
+bool passesMillerRabin(uint128 n, int rounds, std::mt19937& rng) {
+    uint128 d = n - 1;
+    int s = 0;
+    while ((d & 1) == 0) {
+        d >>= 1;
+        s++;
+    }
+
+    if (n < ((uint128)1 << 63)) {
+        MontgomeryContext ctx((uint64_t)n);
+        for (uint64_t a : DETERMINISTIC_BASES) {
+            if (!millerRabinRound<MontgomeryContext, uint64_t>(ctx, (uint64_t)n, (uint64_t)d, s, a)) return false;
+        }
+        return true;
+    }
+
+    WideMontgomery ctx(n);
+    if (n >> 64 == 0) {
+        for (uint64_t a : DETERMINISTIC_BASES) {
+            if (!millerRabinRound<WideMontgomery, uint128>(ctx, n, d, s, a)) return false;
+        }
+        return true;
+    }
+
+    for (int i = 0; i < rounds; i++) {
+        uint128 a = 0;
+        for (int word = 0; word < 4; word++) {
+            a = (a << 32) | rng();
+        }
+        a = 2 + a % (n - 3);   // [2, n - 2]
+        if (!millerRabinRound<WideMontgomery, uint128>(ctx, n, d, s, a)) return false;
+    }
+    return true;
+}
+
+inline uint32_t smallResidue(uint128 n, uint32_t p) {
+    return n >> 64 == 0 ? (uint32_t)((uint64_t)n % p) : (uint32_t)(n % p);
+}
+
+inline bool fitsBits(uint128 n, int bits) {
+    return bits >= 128 || n >> bits == 0;
+}
+
+} // namespace
 
 void PrimeGenerator::initializePrimes() {
 
     largePrimes = {
 
-        982451653LL, 982451707LL, 982451743LL, 982451747LL, 982451749LL,
-        982451767LL, 982451773LL, 982451813LL, 982451819LL, 982451821LL,
+        982451653LL, 982451707LL, 982451737LL, 982451809LL, 982451819LL,
+        982451863LL, 982451927LL, 982451933LL, 982451941LL, 982451957LL,
         
 
         2147483647LL,   // 2^31 - 1 (Mersenne prime)
-        2147483659LL, 2147483693LL, 2147483699LL, 2147483701LL,
-        2147483709LL, 2147483713LL, 2147483719LL, 2147483729LL,
+        2147483659LL, 2147483693LL, 2147483713LL, 2147483743LL,
+        2147483777LL, 2147483783LL, 2147483813LL, 2147483857LL,
         
 
         4294967311LL,   // Large 32-bit prime
         4294967357LL, 4294967371LL, 4294967377LL, 4294967387LL,
-        4294967389LL, 4294967459LL, 4294967477LL, 4294967491LL,
+        4294967389LL, 4294967459LL, 4294967477LL, 4294967497LL,
     };
 }
 
@@ -32,18 +199,188 @@ long long PrimeGenerator::getRandomPrime() {
     return largePrimes[dist(rng)];
 }
 
+const std::vector<long long>& PrimeGenerator::getPrimes() {
+    if (largePrimes.empty()) {
+        initializePrimes();
+    }
+    return largePrimes;
+}
+
 bool PrimeGenerator::isPrime(long long n) {
     if (n < 2) return false;
-    if (n == 2) return true;
-    if (n % 2 == 0) return false;
+    return isProbablePrime((uint128)n);
+}
 
-    for (long long i = 3; i * i <= n; i += 2) {
-        if (n % i == 0) return false;
+bool PrimeGenerator::isProbablePrime(uint128 n, int rounds) {
+    if (n < 2) return false;
+    if ((n & 1) == 0) return n == 2;
+    for (uint32_t p : wheelPrimes()) {
+        if (n == p) return true;
+        if (smallResidue(n, p) == 0) return false;
     }
-    return true;
+    if (n < (uint128)WHEEL_BOUND * WHEEL_BOUND) return true;
+    return passesMillerRabin(n, rounds, rng);
 }
 
 long long PrimeGenerator::generateRandomInRange(long long min, long long max) {
     std::uniform_int_distribution<long long> dist(min, max);
     return dist(rng);
 }
+
+uint128 PrimeGenerator::randomBits(int bits) {
+    uint128 value = 0;
+    for (int word = 0; word < 4; word++) {
+        value = (value << 32) | rng();
+    }
+    if (bits < 128) {
+        value &= ((uint128)1 << bits) - 1;
+    }
+    return value | ((uint128)1 << (bits - 1)) | 1;
+}
+
+uint128 PrimeGenerator::generatePrime(int bits) {
+    if (bits < 2 || bits > 128) {
+        throw std::invalid_argument("Prime bit length must be between 2 and 128");
+    }
+    if (bits == 2) {
+        return 2 + (rng() & 1);
+    }
+
+    // Short lengths: the window would span the whole range, so test directly
+    if (bits <= 16) {
+        while (true) {
+            uint128 candidate = randomBits(bits);
+            if (isProbablePrime(candidate)) return candidate;
+        }
+    }
+
+    const std::vector<uint32_t>& wheel = wheelPrimes();
+    std::vector<char> composite(SIEVE_WINDOW);
+    while (true) {
+        // Window of odd candidates base, base + 2, ...; strike multiples of each wheel prime
+        uint128 base = randomBits(bits);
+        std::fill(composite.begin(), composite.end(), 0);
+        for (uint32_t p : wheel) {
+            uint32_t r = smallResidue(base, p);
+            // base + 2i = 0 (mod p)  <=>  i = -r * 2^-1 (mod p)
+            size_t first = (size_t)((uint64_t)((p - r) % p) * ((p + 1) / 2) % p);
+            for (size_t i = first; i < SIEVE_WINDOW; i += p) {
+                composite[i] = 1;
+            }
+        }
+
+        for (size_t i = 0; i < SIEVE_WINDOW; i++) {
+            if (composite[i]) continue;
+            uint128 candidate = base + 2 * (uint128)i;
+            if (candidate < base || !fitsBits(candidate, bits)) break;
+            if (passesMillerRabin(candidate, 32, rng)) return candidate;
+        }
+    }
+}
+
+uint128 PrimeGenerator::generateSafePrime(int bits) {
+    if (bits < 3 || bits > 128) {
+        throw std::invalid_argument("Safe prime bit length must be between 3 and 128");
+    }
+
+    if (bits <= 16) {
+        while (true) {
+            uint128 q = bits == 3 ? 2 + (rng() & 1) : randomBits(bits - 1);
+            uint128 p = 2 * q + 1;
+            if (fitsBits(p, bits) && p >> (bits - 1) == 1 && isProbablePrime(q) && isProbablePrime(p)) return p;
+        }
+    }
+
+    const std::vector<uint32_t>& wheel = wheelPrimes();
+    std::vector<char> composite(SIEVE_WINDOW);
+    while (true) {
+        // Sieve q = base + 2i so that neither q nor 2q + 1 has a wheel factor
+        uint128 base = randomBits(bits - 1);
+        std::fill(composite.begin(), composite.end(), 0);
+        for (uint32_t p : wheel) {
+            uint32_t r = smallResidue(base, p);
+            uint64_t halfInverse = (p + 1) / 2;
+            size_t qFactor = (size_t)((uint64_t)((p - r) % p) * halfInverse % p);
+            // 2q + 1 = 0 (mod p)  <=>  q = (p - 1) / 2 (mod p)
+            uint32_t target = (p - 1) / 2;
+            size_t pFactor = (size_t)((uint64_t)((target + p - r) % p) * halfInverse % p);
+            for (size_t i = qFactor; i < SIEVE_WINDOW; i += p) composite[i] = 1;
+            for (size_t i = pFactor; i < SIEVE_WINDOW; i += p) composite[i] = 1;
+        }
+
+        for (size_t i = 0; i < SIEVE_WINDOW; i++) {
+            if (composite[i]) continue;
+            uint128 q = base + 2 * (uint128)i;
+            if (q < base || !fitsBits(q, bits - 1)) break;
+            uint128 p = 2 * q + 1;
+            if (passesMillerRabin(q, 32, rng) && passesMillerRabin(p, 32, rng)) {
+                return p;
+            }
+        }
+    }
+}
+
+bool PrimeGenerator::saveParameters(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    out << "# ElGamal prime moduli (safe primes p = 2q + 1), one per line\n";
+    for (long long p : getPrimes()) {
+        out << p << "\n";
+    }
+    return (bool)out;
+}
+
+bool PrimeGenerator::loadParameters(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) return false;
+
+    std::vector<long long> loaded;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        try {
+            long long p = std::stoll(line);
+            // Reject anything ElGamal's arithmetic cannot use or that is not a safe prime
+            if (p < 5 || p >= (1LL << 62) || !isPrime(p) || !isPrime((p - 1) / 2)) return false;
+            loaded.push_back(p);
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    if (loaded.empty()) return false;
+
+    largePrimes = loaded;
+    parameterPath = path;
+    return true;
+}
+
+bool PrimeGenerator::loadOrGenerateParameters(const std::string& path, int count, int bits) {
+    if (path == parameterPath) return false;
+    if (bits < 16 || bits > 62 || count < 1) {
+        throw std::invalid_argument("Parameter primes need 16..62 bits and a positive count");
+    }
+
+    if (loadParameters(path)) {
+        bool matches = true;
+        for (long long p : largePrimes) {
+            matches = matches && fitsBits((uint128)p, bits) && (p >> (bits - 1)) == 1;
+        }
+        if (matches) return false;
+    }
+
+    std::vector<long long> generated;
+    while ((int)generated.size() < count) {
+        long long p = (long long)generateSafePrime(bits);
+        bool duplicate = false;
+        for (long long existing : generated) {
+            duplicate = duplicate || existing == p;
+        }
+        if (!duplicate) generated.push_back(p);
+    }
+
+    largePrimes = generated;
+    parameterPath = path;
+    saveParameters(path);
+    return true;
+}
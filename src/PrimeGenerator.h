@@ -3,17 +3,47 @@
 
 #include <vector>
 #include <random>
+#include <string>
+
+typedef unsigned __int128 uint128;
 
 class PrimeGenerator {
 private:
     static std::vector<long long> largePrimes;
     static std::mt19937 rng;
+    static std::string parameterPath;   // File largePrimes was loaded from, if any
+
+    static uint128 randomBits(int bits);   // Uniform, top bit set, odd
 
 public:
     static void initializePrimes();
     static long long getRandomPrime();
-    static bool isPrime(long long n);
+    static const std::vector<long long>& getPrimes();
     static long long generateRandomInRange(long long min, long long max);
+
+    // Deterministic Miller-Rabin (first 12 prime bases) after small-prime trial division
+    static bool isPrime(long long n);
+
+    // Exact below 2^64; above it, `rounds` Miller-Rabin rounds with random bases
+    // (error probability at most 4^-rounds)
+    static bool isProbablePrime(uint128 n, int rounds = 32);
+
+    // Fresh random prime of exactly `bits` bits (2..128). Candidates come from a
+    // window of odd numbers sieved by the small-prime wheel, so Miller-Rabin only
+    // runs on numbers with no factor below the wheel bound.
+    static uint128 generatePrime(int bits);
+
+    // Safe prime p = 2q + 1 with q prime, `bits` bits (3..128); the sieve rejects
+    // windows where either q or 2q + 1 has a small factor
+    static uint128 generateSafePrime(int bits);
+
+    // Replace the built-in prime table with `count` safe primes of `bits` bits
+    // (bits <= 62 so ElGamal can use them) read from path, generating and writing
+    // the file first if it is missing or unreadable. Returns true if it generated.
+    // Call before the first KeyPool::instance(); reloading the same path is a no-op.
+    static bool loadOrGenerateParameters(const std::string& path, int count, int bits);
+    static bool saveParameters(const std::string& path);
+    static bool loadParameters(const std::string& path);
 };
 
 #endif
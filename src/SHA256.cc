@@ -0,0 +1,442 @@
+#include "SHA256.h"
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SHA256_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+inline uint32_t loadBE32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+inline void storeBE32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+#ifdef SHA256_X86
+
+// Lane-parallel round functions. Each vector register holds the same working
+// variable for 4 (SSE) or 8 (AVX2) independent messages.
+
+__attribute__((target("sse4.1")))
+inline __m128i rotr4(__m128i x, int n) {
+    return _mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - n));
+}
+
+__attribute__((target("sse4.1")))
+void compress4(uint32_t states[8][SHA256::MAX_LANES], const uint8_t* const* blocks) {
+    __m128i w[64];
+    for (int t = 0; t < 16; t++) {
+        w[t] = _mm_set_epi32((int)loadBE32(blocks[3] + 4 * t), (int)loadBE32(blocks[2] + 4 * t),
+                             (int)loadBE32(blocks[1] + 4 * t), (int)loadBE32(blocks[0] + 4 * t));
+    }
+    for (int t = 16; t < 64; t++) {
+        __m128i s0 = _mm_xor_si128(_mm_xor_si128(rotr4(w[t - 15], 7), rotr4(w[t - 15], 18)),
+                                   _mm_srli_epi32(w[t - 15], 3));
+        __m128i s1 = _mm_xor_si128(_mm_xor_si128(rotr4(w[t - 2], 17), rotr4(w[t - 2], 19)),
+                                   _mm_srli_epi32(w[t - 2], 10));
+        w[t] = _mm_add_epi32(_mm_add_epi32(w[t - 16], s0), _mm_add_epi32(w[t - 7], s1));
+    }
+
+    __m128i v[8];
+    for (int i = 0; i < 8; i++) {
+        v[i] = _mm_loadu_si128((const __m128i*)states[i]);
+    }
+    __m128i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+    for (int t = 0; t < 64; t++) {
+        __m128i S1 = _mm_xor_si128(_mm_xor_si128(rotr4(e, 6), rotr4(e, 11)), rotr4(e, 25));
+        __m128i ch = _mm_xor_si128(_mm_and_si128(e, f), _mm_andnot_si128(e, g));
+        __m128i t1 = _mm_add_epi32(_mm_add_epi32(h, S1),
+                                   _mm_add_epi32(_mm_add_epi32(ch, _mm_set1_epi32((int)K[t])), w[t]));
+        __m128i S0 = _mm_xor_si128(_mm_xor_si128(rotr4(a, 2), rotr4(a, 13)), rotr4(a, 22));
+        __m128i maj = _mm_xor_si128(_mm_xor_si128(_mm_and_si128(a, b), _mm_and_si128(a, c)),
+                                    _mm_and_si128(b, c));
+        __m128i t2 = _mm_add_epi32(S0, maj);
+        h = g; g = f; f = e;
+        e = _mm_add_epi32(d, t1);
+        d = c; c = b; b = a;
+        a = _mm_add_epi32(t1, t2);
+    }
+
+    __m128i out[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; i++) {
+        _mm_storeu_si128((__m128i*)states[i], _mm_add_epi32(v[i], out[i]));
+    }
+}
+
+__attribute__((target("avx2")))
+inline __m256i rotr8(__m256i x, int n) {
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+__attribute__((target("avx2")))
+void compress8(uint32_t states[8][SHA256::MAX_LANES], const uint8_t* const* blocks) {
+    __m256i w[64];
+    for (int t = 0; t < 16; t++) {
+        w[t] = _mm256_set_epi32((int)loadBE32(blocks[7] + 4 * t), (int)loadBE32(blocks[6] + 4 * t),
+                                (int)loadBE32(blocks[5] + 4 * t), (int)loadBE32(blocks[4] + 4 * t),
+                                (int)loadBE32(blocks[3] + 4 * t), (int)loadBE32(blocks[2] + 4 * t),
+                                (int)loadBE32(blocks[1] + 4 * t), (int)loadBE32(blocks[0] + 4 * t));
+    }
+    for (int t = 16; t < 64; t++) {
+        __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr8(w[t - 15], 7), rotr8(w[t - 15], 18)),
+                                      _mm256_srli_epi32(w[t - 15], 3));
+        __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr8(w[t - 2], 17), rotr8(w[t - 2], 19)),
+                                      _mm256_srli_epi32(w[t - 2], 10));
+        w[t] = _mm256_add_epi32(_mm256_add_epi32(w[t - 16], s0), _mm256_add_epi32(w[t - 7], s1));
+    }
+
+    __m256i v[8];
+    for (int i = 0; i < 8; i++) {
+        v[i] = _mm256_loadu_si256((const __m256i*)states[i]);
+    }
+    __m256i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+    for (int t = 0; t < 64; t++) {
+        __m256i S1 = _mm256_xor_si256(_mm256_xor_si256(rotr8(e, 6), rotr8(e, 11)), rotr8(e, 25));
+        __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, S1),
+                                      _mm256_add_epi32(_mm256_add_epi32(ch, _mm256_set1_epi32((int)K[t])), w[t]));
+        __m256i S0 = _mm256_xor_si256(_mm256_xor_si256(rotr8(a, 2), rotr8(a, 13)), rotr8(a, 22));
+        __m256i maj = _mm256_xor_si256(_mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(a, c)),
+                                       _mm256_and_si256(b, c));
+        __m256i t2 = _mm256_add_epi32(S0, maj);
+        h = g; g = f; f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c; c = b; b = a;
+        a = _mm256_add_epi32(t1, t2);
+    }
+
+    __m256i out[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; i++) {
+        _mm256_storeu_si256((__m256i*)states[i], _mm256_add_epi32(v[i], out[i]));
+    }
+}
+
+#endif // SHA256_X86
+
+// Number of 64-byte blocks after FIPS 180-4 padding
+inline size_t paddedBlockCount(size_t length) {
+    return (length + 9 + SHA256::BLOCK_SIZE - 1) / SHA256::BLOCK_SIZE;
+}
+
+// Writes the padded message into out (paddedBlockCount(length) * 64 bytes)
+void padMessage(const uint8_t* data, size_t length, uint8_t* out) {
+    size_t total = paddedBlockCount(length) * SHA256::BLOCK_SIZE;
+    memcpy(out, data, length);
+    out[length] = 0x80;
+    memset(out + length + 1, 0, total - length - 1);
+    uint64_t bits = (uint64_t)length * 8;
+    for (int i = 0; i < 8; i++) {
+        out[total - 1 - i] = (uint8_t)(bits >> (8 * i));
+    }
+}
+
+// Lays out midstate tail + suffix + padding in out; returns the block count (1-3)
+size_t padMidstateTail(const SHA256::Midstate& midstate, const uint8_t* suffix, size_t suffixLength,
+                       uint8_t* out) {
+    size_t length = midstate.tailLength + suffixLength;
+    size_t blocks = paddedBlockCount(length);
+    size_t total = blocks * SHA256::BLOCK_SIZE;
+    memcpy(out, midstate.tail, midstate.tailLength);
+    memcpy(out + midstate.tailLength, suffix, suffixLength);
+    out[length] = 0x80;
+    memset(out + length + 1, 0, total - length - 1);
+    uint64_t bits = (midstate.prefixLength + suffixLength) * 8;
+    for (int i = 0; i < 8; i++) {
+        out[total - 1 - i] = (uint8_t)(bits >> (8 * i));
+    }
+    return blocks;
+}
+
+} // namespace
+
+const uint32_t SHA256::INITIAL_STATE[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+SHA256::Backend SHA256::activeBackend = SHA256::detectBackend();
+
+SHA256::Backend SHA256::detectBackend() {
+#ifdef SHA256_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return BACKEND_AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return BACKEND_SSE41;
+#endif
+    return BACKEND_SCALAR;
+}
+
+SHA256::Backend SHA256::getBackend() {
+    return activeBackend;
+}
+
+void SHA256::setBackend(Backend backend) {
+    Backend supported = detectBackend();
+    activeBackend = backend > supported ? supported : backend;
+}
+
+int SHA256::getLaneCount() {
+    switch (activeBackend) {
+        case BACKEND_AVX2: return 8;
+        case BACKEND_SSE41: return 4;
+        default: return 1;
+    }
+}
+
+const char* SHA256::backendName(Backend backend) {
+    switch (backend) {
+        case BACKEND_AVX2: return "AVX2 x8";
+        case BACKEND_SSE41: return "SSE4.1 x4";
+        default: return "scalar";
+    }
+}
+
+void SHA256::compress(uint32_t state[8], const uint8_t block[BLOCK_SIZE]) {
+    uint32_t w[64];
+    for (int t = 0; t < 16; t++) {
+        w[t] = loadBE32(block + 4 * t);
+    }
+    for (int t = 16; t < 64; t++) {
+        uint32_t s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+        uint32_t s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+        w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int t = 0; t < 64; t++) {
+        uint32_t S1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        uint32_t ch = (e & f) ^ (~e & g);
+        uint32_t t1 = h + S1 + ch + K[t] + w[t];
+        uint32_t S0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = S0 + maj;
+        h = g; g = f; f = e;
+        e = d + t1;
+        d = c; c = b; b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void SHA256::compressLanes(uint32_t states[8][MAX_LANES], const uint8_t* const* blocks, int lanes) {
+#ifdef SHA256_X86
+    if (lanes > 1 && activeBackend != BACKEND_SCALAR) {
+        // Unused lanes re-hash lane 0's block; their state is never read back
+        const uint8_t* padded[MAX_LANES];
+        for (int i = 0; i < MAX_LANES; i++) {
+            padded[i] = blocks[i < lanes ? i : 0];
+        }
+        if (activeBackend == BACKEND_AVX2 && lanes > 4) {
+            compress8(states, padded);
+            return;
+        }
+        if (lanes <= 4) {
+            compress4(states, padded);
+            return;
+        }
+        // 5-8 lanes on SSE4.1: two passes over the upper and lower halves
+        uint32_t upper[8][MAX_LANES];
+        for (int i = 0; i < 8; i++) {
+            memcpy(upper[i], states[i] + 4, 4 * sizeof(uint32_t));
+        }
+        compress4(states, padded);
+        compress4(upper, padded + 4);
+        for (int i = 0; i < 8; i++) {
+            memcpy(states[i] + 4, upper[i], 4 * sizeof(uint32_t));
+        }
+        return;
+    }
+#endif
+    for (int lane = 0; lane < lanes; lane++) {
+        uint32_t state[8];
+        for (int i = 0; i < 8; i++) state[i] = states[i][lane];
+        compress(state, blocks[lane]);
+        for (int i = 0; i < 8; i++) states[i][lane] = state[i];
+    }
+}
+
+void SHA256::hash(const uint8_t* data, size_t length, uint8_t digest[DIGEST_SIZE]) {
+    uint32_t state[8];
+    memcpy(state, INITIAL_STATE, sizeof(state));
+
+    // Full blocks straight from the input
+    size_t fullBlocks = length / BLOCK_SIZE;
+    for (size_t i = 0; i < fullBlocks; i++) {
+        compress(state, data + i * BLOCK_SIZE);
+    }
+
+    // Padded tail (one or two blocks) on the stack
+    uint8_t tail[2 * BLOCK_SIZE];
+    size_t remaining = length - fullBlocks * BLOCK_SIZE;
+    padMessage(data + fullBlocks * BLOCK_SIZE, remaining, tail);
+    // Length field must cover the whole message, not just the tail
+    size_t tailBlocks = paddedBlockCount(remaining);
+    uint64_t bits = (uint64_t)length * 8;
+    for (int i = 0; i < 8; i++) {
+        tail[tailBlocks * BLOCK_SIZE - 1 - i] = (uint8_t)(bits >> (8 * i));
+    }
+    for (size_t i = 0; i < tailBlocks; i++) {
+        compress(state, tail + i * BLOCK_SIZE);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        storeBE32(digest + 4 * i, state[i]);
+    }
+}
+
+void SHA256::hashBatch(const uint8_t* const* data, const size_t* lengths, size_t count,
+                       uint8_t* digests) {
+    int laneCount = getLaneCount();
+    if (laneCount == 1) {
+        for (size_t i = 0; i < count; i++) {
+            hash(data[i], lengths[i], digests + i * DIGEST_SIZE);
+        }
+        return;
+    }
+
+    vector<uint8_t> padded;
+    for (size_t first = 0; first < count; first += laneCount) {
+        int lanes = (int)min((size_t)laneCount, count - first);
+
+        // Pad every lane's message into one contiguous buffer
+        size_t offsets[MAX_LANES];
+        size_t blockCounts[MAX_LANES];
+        size_t maxBlocks = 0;
+        size_t total = 0;
+        for (int lane = 0; lane < lanes; lane++) {
+            blockCounts[lane] = paddedBlockCount(lengths[first + lane]);
+            offsets[lane] = total;
+            total += blockCounts[lane] * BLOCK_SIZE;
+            maxBlocks = max(maxBlocks, blockCounts[lane]);
+        }
+        padded.resize(total);
+        for (int lane = 0; lane < lanes; lane++) {
+            padMessage(data[first + lane], lengths[first + lane], padded.data() + offsets[lane]);
+        }
+
+        uint32_t states[8][MAX_LANES];
+        for (int i = 0; i < 8; i++) {
+            for (int lane = 0; lane < MAX_LANES; lane++) states[i][lane] = INITIAL_STATE[i];
+        }
+
+        // Lanes that run out of blocks keep hashing their last block; their
+        // digest was already emitted, so the extra work is simply discarded
+        for (size_t blockIndex = 0; blockIndex < maxBlocks; blockIndex++) {
+            const uint8_t* blocks[MAX_LANES];
+            for (int lane = 0; lane < lanes; lane++) {
+                size_t b = blockIndex < blockCounts[lane] ? blockIndex : blockCounts[lane] - 1;
+                blocks[lane] = padded.data() + offsets[lane] + b * BLOCK_SIZE;
+            }
+            compressLanes(states, blocks, lanes);
+
+            for (int lane = 0; lane < lanes; lane++) {
+                if (blockIndex + 1 != blockCounts[lane]) continue;
+                uint8_t* out = digests + (first + lane) * DIGEST_SIZE;
+                for (int i = 0; i < 8; i++) {
+                    storeBE32(out + 4 * i, states[i][lane]);
+                }
+            }
+        }
+    }
+}
+
+void SHA256::computeMidstate(const uint8_t* prefix, size_t length, Midstate& midstate) {
+    memcpy(midstate.state, INITIAL_STATE, sizeof(midstate.state));
+    size_t fullBlocks = length / BLOCK_SIZE;
+    for (size_t i = 0; i < fullBlocks; i++) {
+        compress(midstate.state, prefix + i * BLOCK_SIZE);
+    }
+    midstate.tailLength = length - fullBlocks * BLOCK_SIZE;
+    memcpy(midstate.tail, prefix + fullBlocks * BLOCK_SIZE, midstate.tailLength);
+    midstate.prefixLength = length;
+}
+
+void SHA256::finishMidstate(const Midstate& midstate, const uint8_t* suffix, size_t suffixLength,
+                            uint8_t digest[DIGEST_SIZE]) {
+    uint8_t buffer[3 * BLOCK_SIZE];
+    size_t blocks = padMidstateTail(midstate, suffix, suffixLength, buffer);
+
+    uint32_t state[8];
+    memcpy(state, midstate.state, sizeof(state));
+    for (size_t i = 0; i < blocks; i++) {
+        compress(state, buffer + i * BLOCK_SIZE);
+    }
+    for (int i = 0; i < 8; i++) {
+        storeBE32(digest + 4 * i, state[i]);
+    }
+}
+
+void SHA256::finishMidstateBatch(const Midstate& midstate, const uint8_t* const* suffixes,
+                                 const size_t* suffixLengths, int count, uint8_t* digests) {
+    int laneCount = getLaneCount();
+    if (laneCount == 1) {
+        for (int i = 0; i < count; i++) {
+            finishMidstate(midstate, suffixes[i], suffixLengths[i], digests + i * DIGEST_SIZE);
+        }
+        return;
+    }
+
+    uint8_t buffers[MAX_LANES][3 * BLOCK_SIZE];
+    for (int first = 0; first < count; first += laneCount) {
+        int lanes = min(laneCount, count - first);
+
+        size_t blockCounts[MAX_LANES];
+        size_t maxBlocks = 0;
+        for (int lane = 0; lane < lanes; lane++) {
+            blockCounts[lane] = padMidstateTail(midstate, suffixes[first + lane],
+                                                suffixLengths[first + lane], buffers[lane]);
+            maxBlocks = max(maxBlocks, blockCounts[lane]);
+        }
+
+        uint32_t states[8][MAX_LANES];
+        for (int i = 0; i < 8; i++) {
+            for (int lane = 0; lane < MAX_LANES; lane++) states[i][lane] = midstate.state[i];
+        }
+
+        // Same lane retirement scheme as hashBatch
+        for (size_t blockIndex = 0; blockIndex < maxBlocks; blockIndex++) {
+            const uint8_t* blocks[MAX_LANES];
+            for (int lane = 0; lane < lanes; lane++) {
+                size_t b = blockIndex < blockCounts[lane] ? blockIndex : blockCounts[lane] - 1;
+                blocks[lane] = buffers[lane] + b * BLOCK_SIZE;
+            }
+            compressLanes(states, blocks, lanes);
+
+            for (int lane = 0; lane < lanes; lane++) {
+                if (blockIndex + 1 != blockCounts[lane]) continue;
+                uint8_t* out = digests + (first + lane) * DIGEST_SIZE;
+                for (int i = 0; i < 8; i++) {
+                    storeBE32(out + 4 * i, states[i][lane]);
+                }
+            }
+        }
+    }
+}
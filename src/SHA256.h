@@ -0,0 +1,69 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <cstdint>
+#include <cstddef>
+
+// FIPS 180-4 SHA-256
+// The batch entry point hashes several independent messages at once, one message
+// per SIMD lane (4 lanes with SSE4.1, 8 lanes with AVX2). The kernel is picked at
+// runtime from the CPU features, with a portable scalar fallback.
+class SHA256 {
+public:
+    static const size_t DIGEST_SIZE = 32;
+    static const size_t BLOCK_SIZE = 64;
+    static const int MAX_LANES = 8;
+
+    enum Backend {
+        BACKEND_SCALAR = 0,
+        BACKEND_SSE41 = 1,   // 4 messages per kernel call
+        BACKEND_AVX2 = 2     // 8 messages per kernel call
+    };
+
+    static const uint32_t INITIAL_STATE[8];
+
+    // Compression state after absorbing a fixed message prefix. Finishing from a
+    // midstate only compresses the prefix remainder plus the suffix.
+    struct Midstate {
+        uint32_t state[8];
+        uint8_t tail[BLOCK_SIZE];   // Prefix bytes after the last full block
+        size_t tailLength;
+        uint64_t prefixLength;      // Total prefix bytes, including the tail
+    };
+
+    // Longest suffix accepted by the finish functions
+    static const size_t MAX_SUFFIX = BLOCK_SIZE;
+
+    // Single message
+    static void hash(const uint8_t* data, size_t length, uint8_t digest[DIGEST_SIZE]);
+
+    // Hash `count` independent messages, writing count * DIGEST_SIZE bytes to digests
+    static void hashBatch(const uint8_t* const* data, const size_t* lengths, size_t count,
+                          uint8_t* digests);
+
+    // Absorb a prefix once; finish any number of prefix+suffix messages from it.
+    // Finishing never allocates.
+    static void computeMidstate(const uint8_t* prefix, size_t length, Midstate& midstate);
+    static void finishMidstate(const Midstate& midstate, const uint8_t* suffix, size_t suffixLength,
+                               uint8_t digest[DIGEST_SIZE]);
+    static void finishMidstateBatch(const Midstate& midstate, const uint8_t* const* suffixes,
+                                    const size_t* suffixLengths, int count, uint8_t* digests);
+
+    // Raw compression function over one 64-byte block
+    static void compress(uint32_t state[8], const uint8_t block[BLOCK_SIZE]);
+
+    // Multi-buffer compression: lane i advances states[word][i] over blocks[i]
+    static void compressLanes(uint32_t states[8][MAX_LANES], const uint8_t* const* blocks, int lanes);
+
+    // Backend selection (defaults to the best the CPU supports)
+    static Backend getBackend();
+    static void setBackend(Backend backend);  // Clamped to what the CPU supports
+    static Backend detectBackend();
+    static int getLaneCount();
+    static const char* backendName(Backend backend);
+
+private:
+    static Backend activeBackend;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "ValidatedBlock.h"
+#include "ElGamal.h"
+#include <stdexcept>
+
+using namespace std;
+
+ValidatedBlock::ValidatedBlock(const string& serialized)
+    : block(Block::deserialize(serialized)), miningHash(Digest::zero()), payload(PAYLOAD_OK),
+      blockIdReady(false), miningHashReady(false), payloadChecked(false) {}
+
+const string& ValidatedBlock::getBlockId() const {
+    if (!blockIdReady) {
+        blockId = block.getBlockIdentifier();
+        blockIdReady = true;
+    }
+    return blockId;
+}
+
+const Digest& ValidatedBlock::getMiningHash() const {
+    if (!miningHashReady) {
+        miningHash = block.calculateMiningHash();
+        miningHashReady = true;
+    }
+    return miningHash;
+}
+
+ValidatedBlock::PayloadCheck ValidatedBlock::checkPayload() const {
+    if (payloadChecked) {
+        return payload;
+    }
+    payloadChecked = true;
+
+    const string& encrypted = block.getEncryptedData();
+    long long p = block.getPublicKey().p;
+    if (encrypted.empty()) {
+        return payload = PAYLOAD_EMPTY;
+    }
+
+    try {
+        if (CiphertextView::isBinary(encrypted)) {
+            // Walk the binary pairs in place
+            CiphertextView ciphertext = CiphertextView::parse(encrypted);
+            if (ciphertext.size() == 0) {
+                return payload = PAYLOAD_OUT_OF_GROUP;
+            }
+            for (CipherBlock pair : ciphertext) {
+                if (pair.c1 <= 0 || pair.c1 >= p || pair.c2 < 0 || pair.c2 >= p) {
+                    return payload = PAYLOAD_OUT_OF_GROUP;
+                }
+            }
+        } else if (ElGamal::isHybrid(encrypted)) {
+            // Only the capsule is checkable without the private key
+            long long capsule = ElGamal::hybridCapsule(encrypted);
+            if (capsule <= 0 || capsule >= p) {
+                return payload = PAYLOAD_OUT_OF_GROUP;
+            }
+        } else if (encrypted.find(",") == string::npos || encrypted.find(";") == string::npos) {
+            return payload = PAYLOAD_MALFORMED;   // Not even legacy text ciphertext
+        }
+    } catch (const invalid_argument&) {
+        return payload = PAYLOAD_MALFORMED;
+    }
+    return payload = PAYLOAD_OK;
+}
+
+bool ValidatedBlock::hasPlausibleKey() const {
+    const PublicKey& key = block.getPublicKey();
+    return key.p >= 1000 && key.e1 >= 2 && key.e2 >= 2;
+}
+
+bool ValidatedBlock::isValid(bool requireProofOfWork) const {
+    if (block.getBlockNumber() < 0 || checkPayload() != PAYLOAD_OK) {
+        return false;
+    }
+    return !requireProofOfWork || !isMined() || hasValidProofOfWork();
+}
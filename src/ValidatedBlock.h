@@ -0,0 +1,56 @@
+#ifndef VALIDATEDBLOCK_H
+#define VALIDATEDBLOCK_H
+
+#include <string>
+#include "Block.h"
+#include "Digest.h"
+
+using namespace std;
+
+// A received block parsed once, with the checks every consumer of a proposal
+// needs (identifier, mining digest, proof-of-work, payload and key structure)
+// computed on first use and memoized. Passed by reference from the proposal
+// handler through the fuzzy decision to the chain append, so a proposal costs
+// one parse and at most one header hash however many stages look at it.
+class ValidatedBlock {
+public:
+    enum PayloadCheck {
+        PAYLOAD_OK = 0,
+        PAYLOAD_EMPTY,            // No encrypted data at all
+        PAYLOAD_MALFORMED,        // Ciphertext framing does not parse
+        PAYLOAD_OUT_OF_GROUP      // Ciphertext values outside the key's group
+    };
+
+private:
+    Block block;
+    mutable string blockId;
+    mutable Digest miningHash;
+    mutable PayloadCheck payload;
+    mutable bool blockIdReady;
+    mutable bool miningHashReady;
+    mutable bool payloadChecked;
+
+public:
+    // Throws invalid_argument (or what Block::deserialize throws) for malformed bytes
+    explicit ValidatedBlock(const string& serialized);
+
+    const Block& getBlock() const { return block; }
+    // Hands the parsed block on (e.g. to the chain); memoized results stay readable
+    Block&& releaseBlock() { return move(block); }
+    const string& getBlockId() const;
+
+    // Header digest, hashed once
+    const Digest& getMiningHash() const;
+    bool isMined() const { return block.getNonce() > 0; }
+    bool hasValidProofOfWork() const { return isMined() && getMiningHash().meetsTarget(block.getTarget()); }
+
+    // Checkable without the private key: ciphertext framing and ranges, key parameters
+    PayloadCheck checkPayload() const;
+    bool hasPlausibleKey() const;
+
+    // Structure plus, when requireProofOfWork, a valid digest for mined blocks
+    // (the public-data counterpart of Block::isValidBlock, which must decrypt)
+    bool isValid(bool requireProofOfWork) const;
+};
+
+#endif